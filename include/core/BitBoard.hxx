@@ -0,0 +1,181 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+#ifndef VOXIGAME_CORE_BITBOARD_HXX
+#define VOXIGAME_CORE_BITBOARD_HXX
+
+#include <QVector>
+#include "core/Coord.hxx"
+#include "core/Box.hxx"
+class Piece;
+
+/**
+ * A bitboard describes a boolean value for each voxel of a box, using one bit
+ * per voxel. Each row (along the X axis) is packed in 64-bit words, so that
+ * the voxels of a row can be tested together.
+ */
+class BitBoard {
+public:
+  /** a word of a bitboard, identified by its offset */
+  class Word {
+  public:
+    /** offset of the word in the bitboard */
+    unsigned int offset;
+    /** bits of the word */
+    quint64 bits;
+
+    /** constructor */
+    Word(unsigned int o = 0, quint64 b = 0) : offset(o), bits(b) { }
+
+    /** comparison operator used by ordering algorithms */
+    inline bool operator<(const Word & w) const {
+      return offset < w.offset;
+    }
+  };
+
+  /** a mask is a sparse description of a set of voxels, i.e. the list of the
+      non-empty words, ordered by offset */
+  typedef QVector<Word> Mask;
+
+private:
+  /** area */
+  Box box;
+
+  /** number of words in a row */
+  unsigned int nbWordsX;
+
+  /** bits */
+  QVector<quint64> words;
+
+  /** return the mask word at the given offset (0 if not contained by the mask) */
+  static quint64 getWord(const Mask & mask, unsigned int offset);
+
+  /** bits of the valid voxels in the given word of a row (the last word of
+      a row may be partially used) */
+  inline quint64 getValidBits(unsigned int wx) const {
+    const unsigned int r = box.getSizeX() & 63;
+    return ((wx + 1 == nbWordsX) && (r != 0)) ? (Q_UINT64_C(1) << r) - 1 : ~Q_UINT64_C(0);
+  }
+
+  /** extend the \p reached voxels along the unset voxels of the bitboard,
+      until convergence, or until the \p nb given voxels are reached (if \p nb
+      is not 0). Return true if all the given voxels have been reached. */
+  bool fillFree(QVector<quint64> & reached, const Coord * targets, unsigned int nb) const;
+
+public:
+  /** constructor */
+  BitBoard(const Box & b = Box());
+
+  /** copy constructor */
+  BitBoard(const BitBoard & b) : box(b.box), nbWordsX(b.nbWordsX), words(b.words) {
+  }
+
+  /** copy operator */
+  inline BitBoard & operator=(const BitBoard & b) {
+    box = b.box;
+    nbWordsX = b.nbWordsX;
+    words = b.words;
+    return *this;
+  }
+
+  /** accessor */
+  inline const Box & getBox() const { return box; }
+
+  /** number of words of a bitboard of the given box */
+  inline static quint64 getNbWords(const Box & b) {
+    return (quint64)((b.getSizeX() + 63) / 64) * b.getSizeY() * b.getSizeZ();
+  }
+
+  /** accessor */
+  inline unsigned int getNbWordsX() const { return nbWordsX; }
+
+  /** accessor */
+  inline const QVector<quint64> & getWords() const { return words; }
+
+  /** offset of the word containing the given voxel (inside the box) */
+  inline unsigned int getWordOffset(const Coord & c) const {
+    Q_ASSERT(box.contains(c));
+    const Coord & c1 = box.getCorner1();
+    return ((c.getZ() - c1.getZ()) * box.getSizeY() + (c.getY() - c1.getY())) * nbWordsX
+      + ((c.getX() - c1.getX()) >> 6);
+  }
+
+  /** mask of the given voxel (inside the box) in its word */
+  inline quint64 getBit(const Coord & c) const {
+    return Q_UINT64_C(1) << ((c.getX() - box.getCorner1().getX()) & 63);
+  }
+
+  /** return true if the given voxel is set (false outside of the box) */
+  inline bool get(const Coord & c) const {
+    return box.contains(c) && ((words[getWordOffset(c)] & getBit(c)) != 0);
+  }
+
+  /** set the given voxel (inside the box) */
+  inline BitBoard & set(const Coord & c) {
+    words[getWordOffset(c)] |= getBit(c);
+    return *this;
+  }
+
+  /** reset the given voxel (inside the box) */
+  inline BitBoard & reset(const Coord & c) {
+    words[getWordOffset(c)] &= ~getBit(c);
+    return *this;
+  }
+
+  /** set all the voxels described by the mask */
+  BitBoard & set(const Mask & mask);
+
+  /** reset all the voxels described by the mask */
+  BitBoard & reset(const Mask & mask);
+
+  /** reset all the voxels */
+  BitBoard & clear();
+
+  /** return the mask of the voxels of the given piece contained by the box */
+  Mask getMask(const Piece & piece) const;
+
+  /** return the mask of the given voxels (translated by \p t) contained by the box */
+  Mask getMask(const Coord * voxels, unsigned int nb, const Coord & t) const;
+
+  /** return true if one of the voxels described by the mask is set */
+  bool intersects(const Mask & mask) const;
+
+  /** return true if none of the voxels entering the volume described by
+      the mask when it is translated by one voxel in the given direction is set.
+      Voxels outside of the box are considered as unset. */
+  bool isFreeForMove(const Mask & mask, Direction::Type d) const;
+
+  /** return true if a path of unset voxels (6-connected) joins the two
+      given voxels (inside the box) */
+  bool hasFreePath(const Coord & c1, const Coord & c2) const;
+
+  /** return the connected set of unset voxels containing the given voxel */
+  BitBoard getFreeComponent(const Coord & c) const;
+
+  /** set in \p component (a bitboard of the same box) the connected set of unset
+      voxels containing the unset voxel \p c. The fill stops as soon as the \p nb
+      given voxels are reached, thus the component is complete only if the
+      result is false. Return true if all the given voxels are in the component */
+  bool getFreeComponent(const Coord & c, BitBoard & component, const Coord * targets, unsigned int nb) const;
+};
+
+#endif // VOXIGAME_CORE_BITBOARD_HXX
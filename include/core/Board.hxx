@@ -24,6 +24,7 @@
 
 
 #include <QVector>
+#include <QHash>
 #include <QSharedPointer>
 class QDomDocument;
 class QDomElement;
@@ -33,6 +34,16 @@ class QDomElement;
 #include "core/Coord.hxx"
 #include "core/Piece.hxx"
 #include "core/Pattern.hxx"
+#include "core/BitBoard.hxx"
+#include "core/ChunkedArray.hxx"
+#include "core/FreeSpace.hxx"
+#include "core/ShapeRegistry.hxx"
+
+
+namespace MoveStatus {
+  /** result of a move query on a piece of a board */
+  typedef enum MoveStatus { Ok, Outside, Intersection } Type;
+} // namespace MoveStatus
 
 
 class Board {
@@ -40,11 +51,82 @@ private:
   /** area */
   Box box;
 
-  /** the list of pieces in the board */
+  /** shapes of the pieces, with their voxels in each orientation */
+  ShapeRegistry shapes;
+
+  /** shape id of each piece in \p shapes. The pieces are stored in parallel
+      arrays indexed by slot: the piece in slot i is described by the i-st element
+      of \p shapeIds, \p orientations, \p locations, \p boxes and \p pieces.
+      The slot of a piece does not change until it is removed, and the slots of
+      the removed pieces are reused */
+  QVector<quint16> shapeIds;
+  /** orientation of each piece (see Orientation) */
+  QVector<quint8> orientations;
+  /** location of each piece */
+  QVector<Coord> locations;
+  /** bounded box of each piece */
+  QVector<Box> boxes;
+
+  /** piece objects. They are never modified, thus shared by the copies of the
+      board and by the journal: a move replaces the object by a moved copy */
   QVector<QSharedPointer<Piece> > pieces;
 
-  /** list of pieces in each cell of the board */
-  QVector<QSharedPointer<Piece> > * cells;
+  /** generation of each slot, set to a new value when its piece is removed,
+      and restored when the removal is reverted (see Handle) */
+  QVector<quint32> generations;
+
+  /** last generation given to a slot */
+  quint32 lastGeneration;
+
+  /** next slot of each slot, in the list of the pieces (in the order
+      of their addition) or in the list of the free slots */
+  QVector<quint32> nextSlots;
+  /** previous slot of each slot, in the list of the pieces or in the list
+      of the free slots */
+  QVector<quint32> previousSlots;
+
+  /** first and last slots of the list of the pieces */
+  quint32 firstPiece;
+  quint32 lastPiece;
+
+  /** first and last slots of the list of the free slots */
+  quint32 firstFree;
+  quint32 lastFree;
+
+  /** number of pieces */
+  unsigned int nbPieces;
+
+  /** end of the lists of slots */
+  static const quint32 noSlot = 0xFFFFFFFF;
+
+  /** occupancy of each cell of the board: 0 for an empty cell, i + 1 if the
+      cell is only used by the piece in slot i, or \p overlapCell if the cell is used
+      by more than one piece (see \p overlaps). The chunks of cells are shared
+      between the copies of a board, and copied when they are modified */
+  ChunkedArray<quint32> cells;
+
+  /** list of pieces (i + 1 for the piece in slot i) of the cells used by more than one
+      piece, indexed by cell offset. Only used when intersections are allowed */
+  QHash<unsigned int, QVector<quint32> > overlaps;
+
+  /** value of a cell used by more than one piece */
+  static const quint32 overlapCell = 0xFFFFFFFF;
+
+  /** cells used by at least one piece */
+  BitBoard occupied;
+
+  /** cells used by more than one piece */
+  BitBoard overlapped;
+
+  /** voxels of each piece inside the board (masks[i] for the piece in slot i),
+      used by word-parallel tests on \p occupied and \p overlapped */
+  QVector<BitBoard::Mask> masks;
+
+  /** connected components of the free cells, updated with the cells */
+  FreeSpace freeSpace;
+
+  /** Zobrist hash of the pieces, updated with the cells */
+  quint64 hash;
 
   bool allowIntersections;
   bool allowOutside;
@@ -59,29 +141,123 @@ private:
   /** face of the input window */
   Direction::Type face2;
 
-  inline QVector<QSharedPointer<Piece> > & getCell(unsigned int px, unsigned int py, unsigned int pz) {
-    return getCell(Coord(px, py, pz));
+  /** an elementary modification of the board, recorded in the journal */
+  class Operation {
+  public:
+    typedef enum { Add, Move, Remove } Type;
+
+    /** kind of modification */
+    Type type;
+    /** slot of the piece */
+    quint32 slot;
+    /** previous slot in the list of the pieces, for an addition or a removal */
+    quint32 previous;
+    /** direction of a move */
+    Direction::Type direction;
+    /** added or removed piece */
+    QSharedPointer<Piece> piece;
+    /** generation of the slot of the added or removed piece, while it is in the board */
+    quint32 generation;
+
+    /** constructor */
+    Operation(Type t = Add, quint32 s = 0, quint32 pr = 0, Direction::Type d = Direction::Static,
+	      const QSharedPointer<Piece> & p = QSharedPointer<Piece>(),
+	      quint32 g = 0) : type(t), slot(s), previous(pr), direction(d), piece(p), generation(g) {
+    }
+  };
+
+  /** journal of the modifications: the operations of the undo steps,
+      followed by the operations of the open transactions */
+  QVector<Operation> journal;
+
+  /** index in \p journal of the first operation of each undo step */
+  QVector<unsigned int> undoSteps;
+
+  /** operations of the undone steps (the last one is the next to redo) */
+  QVector<QVector<Operation> > redoSteps;
+
+  /** index in \p journal of the first operation of each open transaction */
+  QVector<unsigned int> transactions;
+
+  /** true if the modifications are kept in the undo history */
+  bool undoEnabled;
+
+  /** offset of the given cell in \p cells */
+  inline unsigned int getCellOffset(const Coord & p) const {
+    Q_ASSERT(box.contains(p));
+    const Coord & c = box.getCorner1();
+    return (((p.getX() - c.getX()) * box.getSizeY()) + (p.getY() - c.getY())) * box.getSizeZ() + (p.getZ() - c.getZ());
   }
 
-  inline const QVector<QSharedPointer<Piece> > & getCell(unsigned int px, unsigned int py, unsigned int pz) const {
-    return getCell(Coord(px, py, pz));
+  /** voxels of the piece in slot i, before its translation by \p locations[i] */
+  inline const Coord * getOffsets(unsigned int i) const {
+    return shapes.getVoxels(shapeIds[i], orientations[i]);
   }
 
-  inline const QVector<QSharedPointer<Piece> > & getCell(const Coord & p) const {
-    Q_ASSERT(box.contains(p));
-    return cells[((p.getX() * box.getSizeY()) + p.getY()) * box.getSizeZ() + p.getZ()];
+  /** number of voxels of the piece in slot i */
+  inline unsigned int getNbVoxels(unsigned int i) const {
+    return shapes.getNbVoxels(shapeIds[i]);
   }
 
-  inline QVector<QSharedPointer<Piece> > & getCell(const Coord & p) {
-    Q_ASSERT(box.contains(p));
-    return cells[((p.getX() * box.getSizeY()) + p.getY()) * box.getSizeZ() + p.getZ()];
+  /** return the object of the piece in slot i */
+  inline const QSharedPointer<Piece> & getPiece(unsigned int i) const {
+    return pieces[i];
+  }
+
+  /** number of slots (used or free) */
+  inline unsigned int getNbSlots() const {
+    return generations.size();
   }
 
-  /** remove the given piece from the corresponding cells */
-  void removeFromCells(QSharedPointer<Piece> & p);
+  /** insert the slot after \p previous (or first if \p previous is \p noSlot)
+      in the list given by its first and last slots */
+  void linkSlot(quint32 slot, quint32 previous, quint32 & first, quint32 & last);
+
+  /** remove the slot from the list given by its first and last slots */
+  void unlinkSlot(quint32 slot, quint32 & first, quint32 & last);
+
+  /** insert the given piece in the given slot (free, or a new one), after
+      the slot \p previous in the list of the pieces, without any test */
+  void insertPiece(quint32 slot, quint32 previous, const QSharedPointer<Piece> & piece);
+
+  /** add the given piece after the other ones, and record it in the journal */
+  void appendPiece(const QSharedPointer<Piece> & piece);
+
+  /** remove the piece in the given slot */
+  void erasePiece(quint32 slot);
+
+  /** move the piece in the given slot, without any test */
+  void translatePiece(quint32 slot, Direction::Type d);
+
+  /** add the given operation to the journal, if needed */
+  void record(const Operation & o);
 
-  /** add the given piece in the corresponding cells */
-  void addInCells(QSharedPointer<Piece> & p);
+  /** apply the given operation (recorded before an undo) */
+  void apply(const Operation & o);
+
+  /** revert the given operation */
+  void revert(const Operation & o);
+
+  /** revert the operations of the journal after the given size */
+  void revertJournal(unsigned int size);
+
+  /** clear the journal, the undo history and the transactions */
+  void clearJournal();
+
+  /** remove the given piece (by id) from the corresponding cells */
+  void removeFromCells(quint32 id);
+
+  /** add the given piece (by id) in the corresponding cells */
+  void addInCells(quint32 id);
+
+  /** key of a voxel in the Zobrist hash */
+  static quint64 getVoxelKey(const Coord & c);
+
+  /** contribution of a piece to the Zobrist hash, from the sum of the keys of its voxels */
+  static quint64 getPieceKey(quint64 sum);
+
+  /** return the list of piece ids of the cell at the given offset */
+  QVector<quint32> getCellIds(unsigned int offset) const;
 
   /** assuming that the point is a voxel in the border of the box, it
       returns a direction corresponding to the outside. In order to choose
@@ -89,89 +265,139 @@ private:
       this method needs a boolean to describe if it's the first or the second
       window. */
   Direction::Type getBorderSide(const Coord & point, bool first) const;
+
+  friend class StabilityAnalyzer;
 public:
 
+  /** a stable reference to a piece of a board. It stays valid when the other
+      pieces are added or removed, until its piece is removed */
+  class Handle {
+  private:
+    quint32 slot;
+    quint32 generation;
+
+  public:
+    /** constructor */
+    Handle(quint32 s = noSlot, quint32 g = 0) : slot(s), generation(g) {
+    }
+
+    /** accessor */
+    inline quint32 getSlot() const { return slot; }
+    /** accessor */
+    inline quint32 getGeneration() const { return generation; }
+
+    inline bool operator==(const Handle & h) const {
+      return (slot == h.slot) && (generation == h.generation);
+    }
+
+    inline bool operator!=(const Handle & h) const {
+      return !(*this == h);
+    }
+  };
+
+  /** iterator on the pieces, in the order of their addition. It stays valid
+      when the other pieces are added or removed */
   class iterator {
   private:
-    QVector<QSharedPointer<Piece> >::iterator it;
+    Board * board;
+    quint32 slot;
 
     friend class Board;
   public:
     /** default constructor */
-    iterator(const QVector<QSharedPointer<Piece> >::iterator & i) :it(i) {
+    iterator(Board * b, quint32 s) : board(b), slot(s) {
     }
 
     /** copy constructor */
-    iterator(const iterator & i) : it(i.it) { }
+    iterator(const iterator & i) : board(i.board), slot(i.slot) { }
 
     iterator & operator++() {
-      ++it;
+      slot = (*board).nextSlots[slot];
       return *this;
     }
 
-    inline Piece & operator*() const {
-      return **it;
+    /** the reference stays valid until the piece is moved or removed */
+    inline const Piece & operator*() const {
+      return *((*board).getPiece(slot));
     }
 
     inline bool operator!=(const iterator & i) const {
-      return it != i.it;
+      return slot != i.slot;
     }
 
-    const QVector<QSharedPointer<Piece> >::iterator & getIt() const { return it; }
+    inline const Board * getBoard() const { return board; }
+    inline quint32 getSlot() const { return slot; }
   };
 
   class const_iterator {
   private:
-    QVector<QSharedPointer<Piece> >::const_iterator it;
+    const Board * board;
+    quint32 slot;
 
     friend class Board;
   public:
     /** default constructor */
-    const_iterator(const QVector<QSharedPointer<Piece> >::const_iterator & i) : it(i) {
-    }
-    /** default constructor */
-    const_iterator(const QVector<QSharedPointer<Piece> >::iterator & i) :it(i) {
+    const_iterator(const Board * b, quint32 s) : board(b), slot(s) {
     }
 
     /** copy constructor */
-    const_iterator(const const_iterator & i) : it(i.it) { }
+    const_iterator(const const_iterator & i) : board(i.board), slot(i.slot) { }
 
-    const_iterator(const iterator & i) : it(i.getIt()) { }
+    const_iterator(const iterator & i) : board(i.getBoard()), slot(i.getSlot()) { }
 
     const_iterator & operator++() {
-      ++it;
+      slot = (*board).nextSlots[slot];
       return *this;
     }
 
     inline const Piece & operator*() const {
-      return **it;
+      return *((*board).getPiece(slot));
     }
 
     inline bool operator!=(const const_iterator & i) const {
-      return it != i.it;
+      return slot != i.slot;
     }
 
-    const QVector<QSharedPointer<Piece> >::const_iterator & getIt() const { return it; }
+    inline quint32 getSlot() const { return slot; }
   };
 
 
-  iterator begin() { return iterator(pieces.begin()); }
-  const_iterator begin() const { return const_iterator(pieces.begin()); }
-  iterator end() { return iterator(pieces.end()); }
-  const_iterator end() const { return const_iterator(pieces.end()); }
+  iterator begin() { return iterator(this, firstPiece); }
+  const_iterator begin() const { return const_iterator(this, firstPiece); }
+  iterator end() { return iterator(this, noSlot); }
+  const_iterator end() const { return const_iterator(this, noSlot); }
 
+  /** return a stable reference to the given piece */
+  inline Handle getHandle(const const_iterator & i) const {
+    return Handle(i.getSlot(), generations[i.getSlot()]);
+  }
+
+  /** return true if the piece of the given handle is still in the board */
+  inline bool contains(const Handle & h) const {
+    return (h.getSlot() < getNbSlots()) && !pieces[h.getSlot()].isNull() &&
+      (generations[h.getSlot()] == h.getGeneration());
+  }
+
+  /** return an iterator on the piece of the given handle, or end() if it has been removed */
+  inline iterator find(const Handle & h) {
+    return contains(h) ? iterator(this, h.getSlot()) : end();
+  }
+
+  /** return an iterator on the piece of the given handle, or end() if it has been removed */
+  inline const_iterator find(const Handle & h) const {
+    return contains(h) ? const_iterator(this, h.getSlot()) : end();
+  }
 
-  /** return an interator on the cell at coordinates (x, y, z) */
-  const_iterator begin(unsigned int x, unsigned int y, unsigned int z) const { return const_iterator(getCell(x, y, z).begin()); }
-  /** return an interator on the cell at coordinates (x, y, z) */
-  iterator begin(unsigned int x, unsigned int y, unsigned int z) { return iterator(getCell(x, y, z).begin()); }
 
-  /** return an interator on the cell at coordinates (x, y, z) */
-  const_iterator end(unsigned int x, unsigned int y, unsigned int z) const { return const_iterator(getCell(x, y, z).end()); }
-  /** return an interator on the cell at coordinates (x, y, z) */
-  iterator end(unsigned int x, unsigned int y, unsigned int z) { return iterator(getCell(x, y, z).end()); }
+  /** return the list of pieces contained by the cell at coordinates (x, y, z) */
+  QVector<QSharedPointer<Piece> > getPieces(unsigned int x, unsigned int y, unsigned int z) const;
 
 private:
+  /** id of the piece described by \p i in \p cells */
+  inline quint32 getCellId(const const_iterator & i) const {
+    return i.getSlot() + 1;
+  }
+
   /** return true if the cell at location \p c is empty, except the piece described by i */
   bool isEmpty(const Coord & c, const const_iterator & i) const;
 
@@ -191,32 +417,22 @@ public:
 	const Direction::Type & f1 = Direction::Static, const Direction::Type & f2 = Direction::Static,
 	bool aI = false, bool aO = false);
 
-  /** copy constructor */
-  Board(const Board & b);
-
   /** open the current board loading it from a file */
-  Board(const QString & filename) {
-    cells = NULL;
+  Board(const QString & filename) : lastGeneration(0), nbPieces(0), undoEnabled(false) {
     if (!load(filename))
       throw Exception("Cannot load file");
   }
 
   /** open the current board loading it from a file */
-  Board(QFile & f) {
-    cells = NULL;
+  Board(QFile & f) : lastGeneration(0), nbPieces(0), undoEnabled(false) {
     if (!load(f))
       throw Exception("Cannot load file");
   }
 
   /** destructor */
   virtual ~Board() {
-    if (cells != NULL)
-      delete[] cells;
   }
 
-  /** copy operator */
-  Board & operator=(const Board & b);
-
   /** accessor */
   inline unsigned int getSizeX() const { return box.getSizeX(); }
 
@@ -229,10 +445,9 @@ public:
   /** accessor */
   inline const Box & getBox() const { return box; }
 
-  /** accessor */
-  inline const QVector<QSharedPointer<Piece> > & getPieces() const {
-    return pieces;
-  }
+  /** accessor. The objects of the pieces are shared with the copies of the
+      board, and must not be modified */
+  QVector<QSharedPointer<Piece> > getPieces() const;
 
   /** return the list of free cells (without piece) */
   QVector<Coord> getFreeCells() const;
@@ -251,6 +466,43 @@ public:
 
   Board & removePiece(const iterator & i);
 
+  /** start a transaction: the next modifications (addPiece, addPattern, movePiece
+      and removePiece) can be reverted by rollbackTransaction, in a time
+      proportional to the modifications. The transactions can be nested */
+  void beginTransaction();
+
+  /** validate the modifications of the current transaction. The modifications
+      of a nested transaction become part of the enclosing one */
+  void commitTransaction();
+
+  /** revert the modifications of the current transaction */
+  void rollbackTransaction();
+
+  /** number of open transactions */
+  inline unsigned int getNbTransactions() const {
+    return transactions.size();
+  }
+
+  /** enable or disable the undo history (disabled by default). Each modification
+      outside of a transaction, and each committed transaction, is an undo step */
+  void setUndoEnabled(bool u);
+
+  /** return true if a modification can be undone */
+  inline bool canUndo() const {
+    return transactions.isEmpty() && !undoSteps.isEmpty();
+  }
+
+  /** return true if an undone modification can be applied again */
+  inline bool canRedo() const {
+    return transactions.isEmpty() && !redoSteps.isEmpty();
+  }
+
+  /** revert the last undo step */
+  void undo();
+
+  /** apply again the last undone step */
+  void redo();
+
   /** return true if the given piece is inside the board */
   bool isInsidePiece(const const_iterator & i) const;
 
@@ -265,6 +517,10 @@ public:
       and pieces outside of the board), and static (without movable pieces */
   bool isStaticAndValid() const;
 
+  /** return true if the current board is both valid, and stable: no group
+      of pieces can be translated together (see StabilityAnalyzer) */
+  bool isStableAndValid() const;
+
   /** return true if the current board is without intersections
       and pieces outside of the board */
   bool isValid() const;
@@ -277,25 +533,45 @@ public:
   /** return true if a path exists between the two windows that do not cross any piece */
   bool hasPathBetweenWindows() const;
 
+  /** return the connected components of the free cells of the board,
+      in order to test the connectivity of many pairs of cells */
+  inline const FreeSpace & getFreeSpace() const {
+    return freeSpace;
+  }
+
+  /** return a hash of the pieces of the board (location of their voxels), updated
+      on each modification. The size and the windows of the board are not used */
+  inline quint64 getHash() const {
+    return hash;
+  }
+
   /** do not throws an exception if the given piece can be moved in the given direction */
   void isAvailableLocationForMove(const const_iterator & i, Direction::Type d) const;
 
+  /** return MoveStatus::Ok if the given piece can be moved in the given direction,
+      or the reason why it cannot. Only the voxels entering the new location are tested. */
+  MoveStatus::Type getMoveStatus(const const_iterator & i, Direction::Type d) const;
+
   /** return the number of pieces contained by this board */
   inline unsigned int getNbPieces() const {
-    return pieces.size();
+    return nbPieces;
   }
 
   /** return the number of pieces at the given coordinates (inside the board) */
   inline unsigned int getNbPieces(unsigned int x, unsigned int y, unsigned int z) const {
-    return getNbPieces(x, y, z);
+    return getNbPieces(Coord(x, y, z));
   }
 
   /** return the number of pieces at the given coordinates (inside the board) */
   inline unsigned int getNbPieces(const Coord & p) const {
-    if (box.contains(p))
-      return getCell(p).size();
-    else
+    if (!box.contains(p))
       return 0;
+    const unsigned int offset = getCellOffset(p);
+    const quint32 id = cells[offset];
+    if (id == overlapCell)
+      return overlaps[offset].size();
+    else
+      return id == 0 ? 0 : 1;
   }
 
   /** add an XML description of the current object as a child of the given element */
@@ -328,9 +604,18 @@ public:
   /** return true if the current board and the given one are equal */
   virtual bool operator==(const Board & board) const;
 
+  /** return the canonical form of the board: an encoding of the size, the windows
+      and the voxels of the pieces, minimal over the 24 rotations of the board
+      (and the mirror images if \p mirrors is true). Two boards with the same
+      pieces up to a rotation have the same canonical form */
+  QVector<qint32> getCanonicalForm(bool mirrors = false) const;
+
+  /** return a 64-bit hash of the canonical form of the board */
+  quint64 getCanonicalHash(bool mirrors = false) const;
+
   /** return true if the given piece is contained in the current board (exact location, ...) */
   inline bool hasPiece(const Piece & piece) const {
-    for(const_iterator p = pieces.begin(); p != pieces.end(); ++p)
+    for(const_iterator p = begin(); p != end(); ++p)
       if (piece == *p)
 	return true;
     return false;
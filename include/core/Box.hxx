@@ -118,14 +118,36 @@ public:
                   const Direction::Type & direction = Direction::Xplus,
                   const Coord & translation = Coord(0, 0, 0))
   {
-    Coord c1 = corner1.getTransform(angle, direction, translation);
-    Coord c2 = corner2.getTransform(angle, direction, translation);
-    corner1 = c1;
-    corner2 = c1;
-    add(c2);
+    // each axis of the result is given by an axis of the box, possibly reversed
+    const int * m = Orientation::matrices[Orientation::get(direction, angle)];
+    const int c1[3] = { corner1.getX(), corner1.getY(), corner1.getZ() };
+    const int c2[3] = { corner2.getX(), corner2.getY(), corner2.getZ() };
+    int r1[3];
+    int r2[3];
+    for(unsigned int i = 0; i != 3; ++i) {
+      const int * row = m + 3 * i;
+      const unsigned int j = row[0] != 0 ? 0 : (row[1] != 0 ? 1 : 2);
+      r1[i] = row[j] > 0 ? c1[j] : -c2[j];
+      r2[i] = row[j] > 0 ? c2[j] : -c1[j];
+    }
+    corner1 = Coord(r1[0], r1[1], r1[2]) + translation;
+    corner2 = Coord(r2[0], r2[1], r2[2]) + translation;
+    return *this;
+  }
+
+  /** translate the box in the given direction, with a distance of \p t */
+  inline Box & translate(const Direction::Type & d, int t = 1) {
+    corner1.translate(d, t);
+    corner2.translate(d, t);
     return *this;
   }
 
+  /** create a new box by translation */
+  inline Box getTranslate(const Direction::Type & d, int t = 1) const {
+    Box result(*this);
+    return result.translate(d, t);
+  }
+
   /** create a new box from the current one using first a rotation arround axis Xplus with angle \p angle,
       then reorient the coordinate system along the main given direction, then apply a translation */
   inline Box getTransform(const Angle::Type & angle,
@@ -147,6 +169,25 @@ public:
     return contains(b.corner1) && contains(b.corner2);
   }
 
+  /** return true if the current box and \p b have a common voxel */
+  inline bool intersects(const Box & b) const {
+    return corner1.getX() <= b.corner2.getX() && b.corner1.getX() <= corner2.getX() &&
+           corner1.getY() <= b.corner2.getY() && b.corner1.getY() <= corner2.getY() &&
+           corner1.getZ() <= b.corner2.getZ() && b.corner1.getZ() <= corner2.getZ();
+  }
+
+  /** return the common voxels of the current box and \p b (assuming that
+      the two boxes intersect) */
+  inline Box getIntersection(const Box & b) const {
+    Q_ASSERT(intersects(b));
+    return Box(Coord(qMax(corner1.getX(), b.corner1.getX()),
+		     qMax(corner1.getY(), b.corner1.getY()),
+		     qMax(corner1.getZ(), b.corner1.getZ())),
+	       Coord(qMin(corner2.getX(), b.corner2.getX()),
+		     qMin(corner2.getY(), b.corner2.getY()),
+		     qMin(corner2.getZ(), b.corner2.getZ())));
+  }
+
   /** return true if the current box contains \p c */
   inline bool contains(const Coord & c) const {
     return corner1.getX() <= c.getX() && c.getX() <= corner2.getX() &&
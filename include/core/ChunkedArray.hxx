@@ -0,0 +1,118 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+#ifndef VOXIGAME_CORE_CHUNKEDARRAY_HXX
+#define VOXIGAME_CORE_CHUNKEDARRAY_HXX
+
+#include <QVector>
+#include <QSharedData>
+#include <QSharedDataPointer>
+
+/**
+ * An array split into chunks of 2^B elements, shared between the copies of
+ * the array. A chunk is copied (copy-on-write) when one of its elements is
+ * modified through a shared array, thus a copy of the array costs one pointer
+ * per chunk, and the memory used by the modified copies is proportional to the
+ * number of modified chunks.
+ *
+ * The non-const accessors detach the chunk of the element, thus at() has to
+ * be used to read the elements of a non-const array.
+ */
+template <typename T, unsigned int B = 6>
+class ChunkedArray {
+private:
+  /** number of elements of a chunk */
+  static const unsigned int chunkSize = 1 << B;
+
+  /** a chunk of elements, shared by the arrays */
+  class Chunk : public QSharedData {
+  public:
+    T values[chunkSize];
+
+    /** constructor */
+    Chunk(const T & value) {
+      for(unsigned int i = 0; i != chunkSize; ++i)
+	values[i] = value;
+    }
+  };
+
+  /** chunks of the array */
+  QVector<QSharedDataPointer<Chunk> > chunks;
+
+  /** number of elements */
+  unsigned int nb;
+
+public:
+  /** constructor: an array of \p size copies of \p value (sharing a single chunk) */
+  ChunkedArray(unsigned int size = 0, const T & value = T()) : nb(0) {
+    fill(value, size);
+  }
+
+  /** number of elements */
+  inline unsigned int size() const { return nb; }
+
+  /** read the i-st element */
+  inline const T & at(unsigned int i) const {
+    Q_ASSERT(i < nb);
+    return (*(chunks[i >> B])).values[i & (chunkSize - 1)];
+  }
+
+  /** read the i-st element */
+  inline const T & operator[](unsigned int i) const {
+    return at(i);
+  }
+
+  /** access to the i-st element, detaching its chunk if it is shared */
+  inline T & operator[](unsigned int i) {
+    Q_ASSERT(i < nb);
+    return (*(chunks[i >> B])).values[i & (chunkSize - 1)];
+  }
+
+  /** replace the array by \p size copies of \p value (sharing a single chunk) */
+  void fill(const T & value, unsigned int size) {
+    const QSharedDataPointer<Chunk> chunk(new Chunk(value));
+    chunks.fill(chunk, (size + chunkSize - 1) >> B);
+    nb = size;
+  }
+
+  /** add an element at the end of the array */
+  void push_back(const T & value) {
+    if ((nb & (chunkSize - 1)) == 0)
+      chunks.push_back(QSharedDataPointer<Chunk>(new Chunk(value)));
+    else
+      (*(chunks.back())).values[nb & (chunkSize - 1)] = value;
+    ++nb;
+  }
+
+  /** number of chunks */
+  inline unsigned int getNbChunks() const { return chunks.size(); }
+
+  /** number of chunks shared with the given array (at the same position) */
+  unsigned int getNbSharedChunks(const ChunkedArray & array) const {
+    unsigned int result = 0;
+    for(int i = 0; (i != chunks.size()) && (i != array.chunks.size()); ++i)
+      if (chunks[i].constData() == array.chunks[i].constData())
+	++result;
+    return result;
+  }
+};
+
+#endif // VOXIGAME_CORE_CHUNKEDARRAY_HXX
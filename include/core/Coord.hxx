@@ -92,6 +92,59 @@ namespace Angle {
 } // namespace Angle
 
 
+/**
+ * The 24 orientations of the discrete 3D space, as used by CoordT::transform:
+ * first a rotation arround axis Xplus with a given angle, then a reorientation
+ * of the coordinate system along a main direction. An orientation is described
+ * by its index 4 * direction + angle, and the tables are precomputed.
+ */
+namespace Orientation {
+  /** index of an orientation */
+  typedef unsigned int Type;
+
+  /** number of orientations */
+  static const unsigned int nbOrientations = 24;
+
+  /** rotation matrix of each orientation (row by row) */
+  extern const int matrices[24][9];
+
+  /** index of the orientation obtained by applying the second orientation,
+      then the first one */
+  extern const unsigned char compositions[24][24];
+
+  /** index of the inverse of each orientation */
+  extern const unsigned char inverses[24];
+
+  /** rotation of 90 degrees arround each direction (see Piece::rotate) */
+  extern const unsigned char rotations[6];
+
+  /** orientation corresponding to the given direction and angle */
+  inline Type get(const Direction::Type & d, const Angle::Type & a) {
+    return (d == Direction::Static ? 0 : 4 * d) + a;
+  }
+
+  /** main direction of the given orientation */
+  inline Direction::Type getDirection(Type o) {
+    return (Direction::Type)(o / 4);
+  }
+
+  /** angle of the given orientation */
+  inline Angle::Type getAngle(Type o) {
+    return (Angle::Type)(o % 4);
+  }
+
+  /** orientation obtained by applying \p o2, then \p o1 */
+  inline Type compose(Type o1, Type o2) {
+    return compositions[o1][o2];
+  }
+
+  /** inverse of the given orientation */
+  inline Type inverse(Type o) {
+    return inverses[o];
+  }
+} // namespace Orientation
+
+
 /**
    A class to describe discrete 3D coordinates
  */
@@ -185,6 +238,11 @@ public:
       then reorient the coordinate system along the main given direction, then apply a translation */
   CoordT & transform(const Angle::Type & angle, const Direction::Type & direction = Direction::Xplus, const CoordT & translation = CoordT(0, 0, 0));
 
+  /** transform the \p nb given points (see transform) */
+  static void transform(CoordT * coords, unsigned int nb,
+			const Angle::Type & angle, const Direction::Type & direction = Direction::Xplus,
+			const CoordT & translation = CoordT(0, 0, 0));
+
   /** create a new point from the current one using first a rotation arround axis Xplus with angle \p angle,
       then reorient the coordinate system along the main given direction, then apply a translation */
   inline CoordT getTransform(const Angle::Type & angle, const Direction::Type & direction = Direction::Xplus, const CoordT & translation = CoordT(0, 0, 0)) const {
@@ -277,57 +335,37 @@ CoordT<T> & CoordT<T>::transform(const Angle::Type & angle,
 				 const Direction::Type & direction,
 				 const CoordT & translation)
 {
-  // first apply rotation (counterclockwise)
-  {
-    const T y_ = getY();
-    const T z_ = getZ();
-    switch(angle)  {
-    case Angle::A90:
-      setY(-z_).setZ(y_);
-      break;
-    case Angle::A180:
-      setY(-y_).setZ(-z_);
-      break;
-    case Angle::A270:
-      setY(z_).setZ(-y_);
-      break;
-    case Angle::A0:
-    default:
-      break;
-    }
-  }
+  const int * m = Orientation::matrices[Orientation::get(direction, angle)];
+  const T x_ = x;
+  const T y_ = y;
+  const T z_ = z;
+  x = m[0] * x_ + m[1] * y_ + m[2] * z_ + translation.x;
+  y = m[3] * x_ + m[4] * y_ + m[5] * z_ + translation.y;
+  z = m[6] * x_ + m[7] * y_ + m[8] * z_ + translation.z;
+  return *this;
+}
 
-  // then apply direction
-  {
-    const T x_ = getX();
-    const T y_ = getY();
-    const T z_ = getZ();
-    switch(direction)  {
-    case Direction::Yplus:
-      setX(z_).setY(x_).setZ(y_);
-      break;
-    case Direction::Yminus:
-      setX(z_).setY(-x_).setZ(-y_);
-      break;
-    case Direction::Zplus:
-      setX(y_).setY(z).setZ(x_);
-      break;
-    case Direction::Zminus:
-      setX(-y_).setY(z).setZ(-x_);
-      break;
-    case Direction::Xminus:
-      setX(-x_).setY(-y).setZ(z_);
-      break;
-    case Direction::Xplus:
-    default:
-      break;
-    }
+template <typename T>
+void CoordT<T>::transform(CoordT * coords, unsigned int nb,
+			  const Angle::Type & angle,
+			  const Direction::Type & direction,
+			  const CoordT & translation)
+{
+  const int * m = Orientation::matrices[Orientation::get(direction, angle)];
+  const int m0 = m[0], m1 = m[1], m2 = m[2];
+  const int m3 = m[3], m4 = m[4], m5 = m[5];
+  const int m6 = m[6], m7 = m[7], m8 = m[8];
+  const T tx = translation.x;
+  const T ty = translation.y;
+  const T tz = translation.z;
+  for(unsigned int i = 0; i != nb; ++i) {
+    const T x_ = coords[i].x;
+    const T y_ = coords[i].y;
+    const T z_ = coords[i].z;
+    coords[i].x = m0 * x_ + m1 * y_ + m2 * z_ + tx;
+    coords[i].y = m3 * x_ + m4 * y_ + m5 * z_ + ty;
+    coords[i].z = m6 * x_ + m7 * y_ + m8 * z_ + tz;
   }
-
-  // finally, translation
-  (*this) += translation;
-
-  return *this;
 }
 
 
@@ -0,0 +1,171 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#ifndef VOXIGAME_CORE_EXACTCOVER_HXX
+#define VOXIGAME_CORE_EXACTCOVER_HXX
+
+#include <QVector>
+#include <QSet>
+
+/**
+ * An exact cover problem, solved with the dancing links algorithm (Knuth's
+ * algorithm X on a sparse matrix of circular doubly-linked lists). Each row
+ * covers a set of columns, and a solution is a set of rows covering each
+ * column exactly once. The rows can be grouped, with a maximal number of rows
+ * of each group in a solution (e.g. number of available copies of a piece).
+ *
+ * If the memoization is enabled, the partial states (covered columns and
+ * number of used rows of each group) without solution are stored using
+ * a 64-bit hash, and are not explored again when reached by another
+ * sequence of rows.
+ */
+class ExactCover {
+public:
+  /** a listener is notified for each solution found by the search */
+  class Listener {
+  public:
+    /** destructor */
+    virtual ~Listener() {}
+
+    /** called for each solution (list of rows). The search stops if it returns false */
+    virtual bool onSolution(const QVector<unsigned int> & rows) = 0;
+  };
+
+  /** group of the rows without limitation */
+  static const unsigned int noGroup = 0xFFFFFFFF;
+
+private:
+  /** links of the nodes. Node 0 is the root, nodes 1 to nbColumns are the
+      column headers, then the nodes of the rows */
+  QVector<unsigned int> left;
+  QVector<unsigned int> right;
+  QVector<unsigned int> up;
+  QVector<unsigned int> down;
+
+  /** column header of each node */
+  QVector<unsigned int> column;
+
+  /** row of each node */
+  QVector<unsigned int> row;
+
+  /** number of nodes of each column (index of the header) */
+  QVector<unsigned int> sizes;
+
+  /** group of each row */
+  QVector<unsigned int> groups;
+
+  /** first node of each row */
+  QVector<unsigned int> firsts;
+
+  /** rows of each group */
+  QVector<QVector<unsigned int> > groupRows;
+
+  /** true for the covered columns */
+  QVector<bool> covered;
+
+  /** true for the rows hidden since their group is exhausted */
+  QVector<bool> hidden;
+
+  /** maximal number of rows of each group */
+  QVector<unsigned int> bounds;
+
+  /** number of rows of each group in the current partial solution */
+  QVector<unsigned int> used;
+
+  /** current partial solution */
+  QVector<unsigned int> solution;
+
+  /** number of solutions found by the current search */
+  unsigned int nbSolutions;
+
+  /** true if the current search has been stopped by the listener */
+  bool stopped;
+
+  /** true if the states without solution are stored */
+  bool memoization;
+
+  /** hash of the current partial state */
+  quint64 state;
+
+  /** hashes of the states without solution */
+  QSet<quint64> failures;
+
+  /** maximal number of stored states */
+  static const int maxFailures = 1 << 22;
+
+  /** hash of a column */
+  static quint64 getColumnKey(unsigned int c);
+
+  /** hash of the number of rows used in a group */
+  static quint64 getGroupKey(unsigned int g, unsigned int nb);
+
+  /** remove the given column and the rows using it */
+  void cover(unsigned int c);
+
+  /** restore the given column and the rows using it */
+  void uncover(unsigned int c);
+
+  /** hide the available rows of the given group (the group is exhausted), and
+      add them to the given list */
+  void hideGroup(unsigned int g, QVector<unsigned int> & rows);
+
+  /** restore the given hidden rows */
+  void unhideRows(const QVector<unsigned int> & rows);
+
+  /** recursive search */
+  void searchFrom(Listener & listener);
+
+public:
+  /** constructor */
+  ExactCover(unsigned int nbColumns);
+
+  /** number of columns */
+  inline unsigned int getNbColumns() const { return sizes.size() - 1; }
+
+  /** number of rows */
+  inline unsigned int getNbRows() const { return groups.size(); }
+
+  /** add a group of rows, with the given maximal number of rows in a solution */
+  inline unsigned int addGroup(unsigned int bound) {
+    bounds.push_back(bound);
+    used.push_back(0);
+    groupRows.push_back(QVector<unsigned int>());
+    return bounds.size() - 1;
+  }
+
+  /** add a row covering the given (distinct) columns. Return the index of the row */
+  unsigned int addRow(const QVector<unsigned int> & columns, unsigned int group = noGroup);
+
+  /** enable or disable the memoization of the states without solution */
+  inline ExactCover & setMemoization(bool m) {
+    memoization = m;
+    return *this;
+  }
+
+  /** find the solutions, and notify the listener for each of them. Return the
+      number of solutions found */
+  unsigned int search(Listener & listener);
+
+};
+
+#endif // VOXIGAME_CORE_EXACTCOVER_HXX
@@ -0,0 +1,136 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#ifndef VOXIGAME_CORE_FREESPACE_HXX
+#define VOXIGAME_CORE_FREESPACE_HXX
+
+#include <QVector>
+#include "core/Coord.hxx"
+#include "core/Box.hxx"
+#include "core/BitBoard.hxx"
+#include "core/ChunkedArray.hxx"
+
+/**
+ * Connected components of the free voxels of a box (6-connectivity), given by the
+ * unset voxels of a bitboard. The components are computed with a union-find pass,
+ * then each free voxel has a component label, and testing if two voxels are
+ * connected is a label comparison.
+ *
+ * The structure is maintained when voxels are used or released: a released voxel
+ * is merged with its free neighbours, and a used voxel is tested locally (in its
+ * 3x3x3 neighbourhood). If the used voxel may split a component, the parts are
+ * found by word-parallel flood fills on the bitboard (see BitBoard::getFreeComponent),
+ * and each new part gets a new node. The queries do not modify the structure, and can be called
+ * from several threads.
+ */
+class FreeSpace {
+private:
+  /** used voxels */
+  BitBoard used;
+
+  /** node of each voxel (x + sizeX * (y + sizeY * z)) in the union-find
+      structure. A used voxel may still be a link between other nodes, thus a
+      released voxel gets a new node. */
+  ChunkedArray<unsigned int> nodes;
+
+  /** union-find structure over the nodes. The root of the node of a free
+      voxel identifies its component. */
+  ChunkedArray<unsigned int> parent;
+
+  /** number of components */
+  unsigned int nbComponents;
+
+  /** offset of the given voxel (inside the box) */
+  inline unsigned int getOffset(const Coord & c) const {
+    Q_ASSERT(used.getBox().contains(c));
+    const Coord & c1 = used.getBox().getCorner1();
+    return ((c.getZ() - c1.getZ()) * used.getBox().getSizeY() + (c.getY() - c1.getY())) * used.getBox().getSizeX()
+      + (c.getX() - c1.getX());
+  }
+
+  /** compute the union-find structure from the used voxels */
+  void build();
+
+  /** root of the given node in the union-find structure */
+  unsigned int find(unsigned int n) const;
+
+  /** root of the given node, compressing its path in the union-find structure */
+  unsigned int compress(unsigned int n);
+
+  /** merge the sets of the two given nodes. Return false if they were already
+      in the same set */
+  bool unite(unsigned int n1, unsigned int n2);
+
+  /** return true if all the given voxels (\p nb > 0) are connected by free voxels
+      of the 3x3x3 neighbourhood of \p c */
+  bool areLocallyConnected(const Coord & c, const Coord * voxels, unsigned int nb) const;
+
+  /** update the components after the use of a voxel, given its free neighbours
+      (\p nb > 1), that may be in distinct components */
+  void split(Coord * neighbours, unsigned int nb);
+
+  /** set a new node (thus a new component) to the given voxels */
+  void relabel(const BitBoard & voxels);
+
+public:
+  /** label of the used voxels */
+  static const unsigned int noComponent = 0xFFFFFFFF;
+
+  /** constructor: label the unset voxels of the given bitboard */
+  FreeSpace(const BitBoard & u = BitBoard());
+
+  /** accessor */
+  inline const Box & getBox() const { return used.getBox(); }
+
+  /** number of connected components */
+  inline unsigned int getNbComponents() const {
+    return nbComponents;
+  }
+
+  /** identifier of the component of the given voxel, or \p noComponent if the
+      voxel is used or outside of the box. Identifiers may change after an update. */
+  inline unsigned int getLabel(const Coord & c) const {
+    if (!used.getBox().contains(c) || used.get(c))
+      return noComponent;
+    return find(nodes.at(getOffset(c)));
+  }
+
+  /** return true if the two given voxels are free and connected */
+  inline bool areConnected(const Coord & c1, const Coord & c2) const {
+    const unsigned int l = getLabel(c1);
+    return (l != noComponent) && (l == getLabel(c2));
+  }
+
+  /** return true if the two structures have the same box and the same
+      components (whatever their labels) */
+  bool hasSameComponents(const FreeSpace & space) const;
+
+  /** set the given voxel (inside the box) as used */
+  FreeSpace & use(const Coord & c);
+
+  /** set the given voxel (inside the box) as free */
+  FreeSpace & release(const Coord & c);
+
+};
+
+#endif // VOXIGAME_CORE_FREESPACE_HXX
@@ -0,0 +1,139 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#ifndef VOXIGAME_CORE_GENERATOR_HXX
+#define VOXIGAME_CORE_GENERATOR_HXX
+
+#include <QVector>
+#include <QRandomGenerator>
+#include "core/Coord.hxx"
+#include "core/Board.hxx"
+
+/**
+ * A generator of static boards with a path between two windows. The board is
+ * split into cells of 3x3x3 voxels. The generator routes a path of cells
+ * between the two windows, builds it using pipes (see Pattern::pipe), fills the
+ * other cells with blocks of parallel straight pieces (see Pattern::parallelepiped),
+ * and checks the result using the board tests.
+ */
+class Generator {
+private:
+  /** number of cells in each direction */
+  unsigned int sizeX;
+  unsigned int sizeY;
+  unsigned int sizeZ;
+
+  /** cell of the input window */
+  Coord cell1;
+  /** face of the input window */
+  Direction::Type face1;
+  /** cell of the output window */
+  Coord cell2;
+  /** face of the output window */
+  Direction::Type face2;
+
+  /** minimal number of cells of the path */
+  unsigned int minLength;
+
+  /** maximal number of routed paths for a board */
+  unsigned int maxTries;
+
+  /** if true, the boards are checked for groups of movable pieces (see StabilityAnalyzer) */
+  bool stable;
+
+  /** if true, the boards equal up to a rotation to a previous board are removed */
+  bool unique;
+
+  /** return true if the given cell is inside the board */
+  inline bool containsCell(const Coord & c) const {
+    return (c.getX() >= 0) && (c.getY() >= 0) && (c.getZ() >= 0) &&
+      ((unsigned int)c.getX() < sizeX) && ((unsigned int)c.getY() < sizeY) &&
+      ((unsigned int)c.getZ() < sizeZ);
+  }
+
+  /** index of the given cell */
+  inline unsigned int getCellIndex(const Coord & c) const {
+    return (c.getZ() * sizeY + c.getY()) * sizeX + c.getX();
+  }
+
+  /** location of the central voxel of the given cell */
+  inline static Coord getCellCenter(const Coord & c) {
+    return Coord(3 * c.getX() + 1, 3 * c.getY() + 1, 3 * c.getZ() + 1);
+  }
+
+  /** route a random path of cells between the two windows (depth-first
+      search with backtracking). Return the cells of the path, and the
+      steps as described by Pattern::pipe, or false if no path has been found */
+  bool route(QVector<Coord> & cells, QVector<Direction::Type> & steps,
+	     QRandomGenerator & random) const;
+
+  /** build the board given by the path (steps), without the pieces
+      filling the other cells */
+  Board build(const QVector<Direction::Type> & steps) const;
+
+  /** add the pieces filling the cells outside of the path, given their axis */
+  void fill(Board & board, const QVector<Direction::Type> & axes) const;
+
+  /** return true if the given board satisfies the requirements */
+  bool isValid(const Board & board) const;
+
+public:
+  /** constructor. The windows are described by a cell in the border of the board,
+      and the face of this cell containing the window. Throws an exception if a
+      window is not in the border. */
+  Generator(unsigned int sx, unsigned int sy, unsigned int sz,
+	    const Coord & c1, const Direction::Type & f1,
+	    const Coord & c2, const Direction::Type & f2);
+
+  /** location of the input window in the generated boards */
+  inline Coord getWindow1() const { return getCellCenter(cell1) + face1; }
+
+  /** location of the output window in the generated boards */
+  inline Coord getWindow2() const { return getCellCenter(cell2) + face2; }
+
+  /** set the minimal number of cells of the path */
+  inline Generator & setMinLength(unsigned int l) { minLength = l; return *this; }
+
+  /** set the maximal number of routed paths for a board */
+  inline Generator & setMaxTries(unsigned int t) { maxTries = t; return *this; }
+
+  /** set if the boards are checked for groups of movable pieces */
+  inline Generator & setStable(bool s) { stable = s; return *this; }
+
+  /** set if the boards equal up to a rotation to another generated board are removed
+      (see Board::getCanonicalForm). The threads share the canonical forms of the
+      generated boards */
+  inline Generator & setUnique(bool u) { unique = u; return *this; }
+
+  /** generate a board using the given seed. Return false if no board has been found */
+  bool generate(Board & board, quint32 seed) const;
+
+  /** generate boards using the given number of threads (seeds from \p seed to
+      \p seed + \p nbBoards - 1). Return the generated boards, ordered by seed.
+      If the duplicated boards are removed, the kept board of each class depends
+      on the order of the threads. */
+  QVector<Board> generate(unsigned int nbBoards, unsigned int nbThreads, quint32 seed) const;
+
+};
+
+#endif // VOXIGAME_CORE_GENERATOR_HXX
@@ -30,7 +30,11 @@
 #include "core/Piece.hxx"
 
 /**
- * A pattern is described by angle, direction, translation, and a set of pieces
+ * A pattern is described by angle, direction, translation, and a set of pieces.
+ * The pieces are shared by the copies of a pattern and by the patterns that
+ * contain it: each one is stored with the transformation from its own
+ * coordinate system to the local one of the pattern, and is cloned only
+ * when the pattern is materialized (see getPieces).
  * @author Jean-Marie Favreau
  */
 class Pattern {
@@ -44,8 +48,50 @@ private:
   /** rotation according to the main axis */
   Angle::Type angle;
 
-  /** the list of pieces in the board */
-  QVector<QSharedPointer<Piece> > pieces;
+  /** a piece of the pattern */
+  class Element {
+  private:
+    /** the piece, never modified once added */
+    QSharedPointer<Piece> piece;
+
+    /** orientation of the piece in the local coordinate system */
+    Orientation::Type orientation;
+
+    /** translation of the piece in the local coordinate system */
+    Coord location;
+
+  public:
+    /** constructor. The cache of the piece is filled here, since the
+	piece is then read by all the copies of the element */
+    Element(const QSharedPointer<Piece> & p = QSharedPointer<Piece>(),
+	    Orientation::Type o = 0,
+	    const Coord & l = Coord(0, 0, 0)) : piece(p), orientation(o), location(l) {
+      if (!piece.isNull())
+	(*piece).getVoxels();
+    }
+
+    /** return the same element, in the coordinate system given by the transformation */
+    Element getTransform(const Angle::Type & a, const Direction::Type & d, const Coord & t) const;
+
+    /** number of voxels of the element */
+    inline unsigned int nbVoxels() const { return (*piece).nbVoxels(); }
+
+    /** return the voxels of the element in the local coordinate system */
+    QVector<Coord> getVoxels() const;
+
+    /** return the bounded box of the element in the local coordinate system */
+    inline Box getBoundedBox() const {
+      return (*piece).getBoundedBox().getTransform(Orientation::getAngle(orientation),
+						   Orientation::getDirection(orientation),
+						   location);
+    }
+
+    /** create a new piece corresponding to the element */
+    Piece * createPiece() const;
+  };
+
+  /** the list of pieces in the pattern */
+  QVector<Element> pieces;
 
   /** bounded box, computed automatically, in the local coordinate system */
   Box box;
@@ -61,13 +107,6 @@ public:
       angle(a)
   {}
 
-  /** copy constructor */
-  Pattern(const Pattern & p);
-
-  /** copy operator */
-  Pattern& operator=(const Pattern&);
-
-
   /** load pattern from the given XML document */
   static Pattern load(QDomElement & elem, const QString & name = "pattern");
 
@@ -80,7 +119,9 @@ public:
   /** add a pattern in the current pattern. Pattern is described in the local coordinate system */
   Pattern & addPattern(const Pattern & pattern);
 
-  /** return the list of pieces, in the absolute coordinate system */
+  /** return the list of pieces, in the absolute coordinate system. Each
+      piece is cloned and transformed once, whatever the nesting level of
+      the pattern that added it */
   QVector<QSharedPointer<Piece> > getPieces() const;
 
   /** return the bounded box in the global coordinate system */
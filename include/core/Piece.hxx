@@ -53,6 +53,26 @@ protected:
   /** name of the object */
   virtual const QString getName() const = 0;
 
+  /** invalidate the cached voxels and bounded box. Called when the
+      transformation of the piece is modified */
+  inline void invalidate() { cached = false; }
+
+private:
+  /** voxels of the piece, after transformation (cache) */
+  mutable QVector<Coord> voxels;
+
+  /** bounded box of the piece, after transformation (cache) */
+  mutable Box boundedBox;
+
+  /** true if \p voxels and \p boundedBox are up-to-date. The cache is
+      filled by the first const access, thus reading a piece whose cache is
+      not filled is not thread-safe. The pieces shared by boards and
+      patterns are stored with a filled cache */
+  mutable bool cached;
+
+  /** compute the cached voxels and bounded box */
+  void updateCache() const;
+
 public:
   /** iterator along pieces */
   class const_iterator;
@@ -63,7 +83,7 @@ public:
   }
 
   virtual const_iterator end() const {
-    return const_iterator(*this) + nbVoxels();
+    return const_iterator(*this) + getVoxels().size();
   }
 
   /**
@@ -96,8 +116,8 @@ public:
     inline bool operator!=(const const_iterator & i) const {
       return pos != i.pos;
     }
-    inline Coord operator*() const {
-      return piece.getCoordById(pos);
+    inline const Coord & operator*() const {
+      return piece.getVoxels()[pos];
     }
   };
 
@@ -110,14 +130,18 @@ public:
         const Angle::Type & a = Angle::A0)
     : location(c),
       direction(d),
-      angle(a)
+      angle(a),
+      cached(false)
   {}
 
   /** copy construtor */
   Piece(const Piece & p)
     : location(p.location),
       direction(p.direction),
-      angle(p.angle)
+      angle(p.angle),
+      voxels(p.voxels),
+      boundedBox(p.boundedBox),
+      cached(p.cached)
   {}
 
   /** destructor */
@@ -134,22 +158,28 @@ public:
   virtual Piece * clone() const = 0;
 
   /** get the bounded box of the current piece */
-  inline Box getBoundedBox() const {
-    return getLocalBoundedBox().transform(angle, direction, location);
+  inline const Box & getBoundedBox() const {
+    if (!cached)
+      updateCache();
+    return boundedBox;
+  }
+
+  /** get the voxels of the current piece (after transformation), computed
+      once and updated after each transformation. The first call modifies
+      the cache, thus it must not be concurrent with other reads */
+  inline const QVector<Coord> & getVoxels() const {
+    if (!cached)
+      updateCache();
+    return voxels;
   }
 
   /** get the bounded box of the current piece */
   virtual Box getLocalBoundedBox() const = 0;
 
   /** return true if the current piece and the given one are using
-      a common voxel */
-  bool intersect(const Piece & p) const {
-    for(const_iterator i = begin(); i != end(); ++i)
-      for(const_iterator j = p.begin(); j != p.end(); ++j)
-	if (*i == *j)
-	  return true;
-    return false;
-  }
+      a common voxel. Only the voxels in the intersection of the bounded
+      boxes are compared */
+  bool intersect(const Piece & p) const;
 
   /** tranformation of the given coordinate using the translation and
       rotations that describe the piece's location. */
@@ -183,6 +213,12 @@ public:
   /** move the piece according to the given direction */
   inline Piece & move(Direction::Type d, unsigned int step = 1) {
     location.translate(d, step);
+    if (cached) {
+      // translation of the cached voxels
+      for(QVector<Coord>::iterator v = voxels.begin(); v != voxels.end(); ++v)
+	(*v).translate(d, step);
+      boundedBox.translate(d, step);
+    }
     return *this;
   }
 
@@ -197,6 +233,7 @@ public:
     angle = Angle::A0;
     direction = Direction::Xplus;
     location = Coord(0, 0, 0);
+    invalidate();
     return *this;
   }
 
@@ -210,6 +247,13 @@ public:
       the two pieces have the same coords voxel by voxel) */
   bool isSimilar(const Piece & piece) const;
 
+  /** return the signature of the shape of the piece: its local voxels,
+      normalized over the 24 orientations (the smallest sorted set of voxels
+      once translated to the origin). Two pieces have the same signature
+      if and only if one is a rotation and translation of the other,
+      whatever the order of their voxels */
+  QVector<Coord> getSignature() const;
+
   /** return true if the current piece is using the given location */
   inline bool isUsing(const Coord & c) const {
     for(const_iterator p = begin(); p != end(); ++p)
@@ -225,11 +269,19 @@ public:
    and edges of the object (two adjacent coplanar faces do not create an edge if \p removeFlatEdges = true). */
   QPair<QList<Face>, QList<Edge> > getFacesAndEdges(bool removeFlatEdges = true) const;
 
+  /** return the set of oriented external faces of the current piece, and
+      set both the non-flat edges (\p edges) and all the edges (\p allEdges)
+      of the object, computing the edges only once */
+  QList<Face> getFacesAndEdges(QList<Edge> & edges, QList<Edge> & allEdges) const;
+
 
-  /** group pieces by similarity */
+  /** group pieces by similarity (same signature, see getSignature). The
+      key of each group is a piece without transformation */
   static QMap<AbstractPiece, unsigned int> groupBySimilarity(const QVector<QSharedPointer<Piece> > & pieces);
 
-  /** an ordering using sizes to have an ordered list of pieces */
+  /** an ordering using sizes to have an ordered list of pieces. Pieces
+      with the same sizes are ordered by signature, thus two pieces are
+      equivalent only if they have the same shape */
   bool operator<(const Piece & piece) const;
 
   /** Let [zmin, zmax] be the interval of a piece projected on z.
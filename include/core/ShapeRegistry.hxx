@@ -0,0 +1,170 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+
+#ifndef VOXIGAME_CORE_SHAPEREGISTRY_HXX
+#define VOXIGAME_CORE_SHAPEREGISTRY_HXX
+
+#include <QVector>
+#include <QMap>
+#include <QSharedPointer>
+#include <QPair>
+#include <QList>
+#include "core/Coord.hxx"
+#include "core/Box.hxx"
+#include "core/Piece.hxx"
+
+/**
+ * A registry of piece shapes. Each distinct shape (set of local voxels of a
+ * piece, whatever its type) is interned with an id, and its voxels are
+ * precomputed for the 24 orientations (see Orientation). A placed piece can
+ * then be described by a Placement (shape id, orientation and location), and
+ * its voxels are given by a table lookup.
+ */
+class ShapeRegistry {
+public:
+  /** a placed shape */
+  class Placement {
+  private:
+    /** location */
+    qint16 x;
+    qint16 y;
+    qint16 z;
+    /** shape id */
+    quint16 shape;
+    /** orientation (see Orientation) */
+    quint8 orientation;
+
+  public:
+    /** constructor */
+    Placement(unsigned int s = 0, Orientation::Type o = 0,
+	      const Coord & l = Coord(0, 0, 0)) : x(l.getX()), y(l.getY()), z(l.getZ()),
+						  shape(s), orientation(o) {
+      Q_ASSERT(s < 0x10000);
+      Q_ASSERT(o < Orientation::nbOrientations);
+    }
+
+    /** accessor */
+    inline unsigned int getShape() const { return shape; }
+    /** accessor */
+    inline Orientation::Type getOrientation() const { return orientation; }
+    /** accessor */
+    inline Coord getLocation() const { return Coord(x, y, z); }
+  };
+
+private:
+  /** ids of the shapes, indexed by their sorted local voxels */
+  QMap<QVector<Coord>, unsigned int> ids;
+
+  /** a piece of each shape, without transformation */
+  QVector<QSharedPointer<Piece> > pieces;
+
+  /** number of voxels of each shape */
+  QVector<unsigned int> sizes;
+
+  /** index of the first voxel of each shape in \p offsets */
+  QVector<unsigned int> firsts;
+
+  /** voxels of the shapes: for each shape, the voxels of each orientation
+      (in the order of the local voxels of the first registered piece) */
+  QVector<Coord> offsets;
+
+  /** bounded box of each shape and orientation */
+  QVector<Box> boxes;
+
+  /** faces and edges of a shape with a given orientation (before translation) */
+  class Outline {
+  public:
+    /** true if the faces and edges have been computed */
+    bool computed;
+    /** external faces */
+    QList<Face> faces;
+    /** non-flat edges */
+    QList<Edge> edges;
+    /** all the edges */
+    QList<Edge> allEdges;
+
+    /** constructor */
+    Outline() : computed(false) {}
+  };
+
+  /** faces and edges of each shape and orientation, computed on demand */
+  mutable QVector<Outline> outlines;
+
+  /** return the outline of the given shape and orientation, computing it if needed */
+  const Outline & getOutline(unsigned int shape, Orientation::Type o) const;
+
+public:
+  /** constructor */
+  ShapeRegistry();
+
+  /** return the id of the shape of the given piece (local voxels, without
+      transformation). The shape is added if it is not yet known */
+  unsigned int add(const Piece & piece);
+
+  /** return the id of the shape of the given piece, or -1 if it is not known */
+  int getId(const Piece & piece) const;
+
+  /** number of shapes */
+  inline unsigned int getNbShapes() const { return sizes.size(); }
+
+  /** number of voxels of the given shape */
+  inline unsigned int getNbVoxels(unsigned int shape) const { return sizes[shape]; }
+
+  /** voxels of the given shape with the given orientation (before translation) */
+  inline const Coord * getVoxels(unsigned int shape, Orientation::Type o) const {
+    return offsets.constData() + firsts[shape] + o * sizes[shape];
+  }
+
+  /** bounded box of the given shape with the given orientation (before translation) */
+  inline const Box & getBoundedBox(unsigned int shape, Orientation::Type o) const {
+    return boxes[shape * Orientation::nbOrientations + o];
+  }
+
+  /** voxels of the given placement */
+  QVector<Coord> getVoxels(const Placement & p) const;
+
+  /** bounded box of the given placement */
+  inline Box getBoundedBox(const Placement & p) const {
+    const Box & b = getBoundedBox(p.getShape(), p.getOrientation());
+    return Box(b.getCorner1() + p.getLocation(), b.getCorner2() + p.getLocation());
+  }
+
+  /** return the placement of the given piece, adding its shape if needed */
+  inline Placement getPlacement(const Piece & piece) {
+    return Placement(add(piece), Orientation::get(piece.getDirection(), piece.getAngle()),
+		     piece.getLocation());
+  }
+
+  /** return the external faces and the edges of the given placement (see
+      Piece::getFacesAndEdges). They are computed once per shape and
+      orientation, then translated */
+  QPair<QList<Face>, QList<Edge> > getFacesAndEdges(const Placement & p,
+						    bool removeFlatEdges = true) const;
+
+  /** create a piece corresponding to the given placement */
+  Piece * createPiece(const Placement & p) const;
+
+};
+
+#endif // VOXIGAME_CORE_SHAPEREGISTRY_HXX
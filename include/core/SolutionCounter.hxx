@@ -0,0 +1,120 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+
+#ifndef VOXIGAME_CORE_SOLUTIONCOUNTER_HXX
+#define VOXIGAME_CORE_SOLUTIONCOUNTER_HXX
+
+#include <QVector>
+#include <QSet>
+#include "core/Coord.hxx"
+#include "core/Board.hxx"
+#include "core/Solver.hxx"
+
+/**
+ * Count the distinct solutions of a filling problem (see Solver): the boards
+ * that are static and valid, with a path between the windows. Two solutions
+ * are identical if a rotation of the board preserving the windows and the path
+ * maps the pieces of the first one to the pieces of the second one. These
+ * symmetries are broken during the search (see Solver::setSymmetries), and the
+ * remaining symmetric solutions are removed using a canonical form. The
+ * enumeration stops as soon as the given limit is reached, e.g. after the second
+ * solution when checking the uniqueness.
+ */
+class SolutionCounter : public Solver::Listener {
+private:
+  /** the solver (with memoization) */
+  Solver solver;
+
+  /** maximal number of distinct solutions (0: no limit) */
+  unsigned int limit;
+
+  /** if true, the solutions have to be stable (see StabilityAnalyzer) */
+  bool stable;
+
+  /** rotations of the board preserving the windows and the path: image
+      of each voxel index */
+  QVector<QVector<unsigned int> > symmetries;
+
+  /** canonical forms of the distinct solutions */
+  QSet<QVector<unsigned int> > canonicals;
+
+  /** a representative of each distinct solution */
+  QVector<Board> solutions;
+
+  /** number of boards given by the solver */
+  unsigned int nbBoards;
+
+  /** index of a voxel */
+  inline unsigned int getIndex(const Coord & c) const {
+    return (c.getZ() * solver.getSizeY() + c.getY()) * solver.getSizeX() + c.getX();
+  }
+
+  /** compute the rotations of the board preserving the windows and the path */
+  void computeSymmetries();
+
+  /** canonical form of a board: the smallest labeling of the voxels
+      by the pieces, over the symmetries */
+  QVector<unsigned int> getCanonical(const Board & board) const;
+
+public:
+  /** constructor */
+  SolutionCounter(const Solver & solver);
+
+  /** constructor: count the fillings of the free space of the given board using its pieces */
+  SolutionCounter(const Board & board);
+
+  /** set the maximal number of distinct solutions (0: no limit) */
+  inline SolutionCounter & setLimit(unsigned int l) {
+    limit = l;
+    return *this;
+  }
+
+  /** the solutions have to be stable, not only static */
+  inline SolutionCounter & setStable(bool s) {
+    stable = s;
+    return *this;
+  }
+
+  /** number of symmetries of the problem (including the identity) */
+  inline unsigned int getNbSymmetries() const { return symmetries.size(); }
+
+  /** count the distinct solutions, up to the limit */
+  unsigned int count();
+
+  /** return true if the problem has exactly one solution */
+  bool hasUniqueSolution();
+
+  /** a representative of each distinct solution found by the last count */
+  inline const QVector<Board> & getSolutions() const { return solutions; }
+
+  /** number of boards (without removing the invalid and symmetric ones)
+      enumerated by the last count */
+  inline unsigned int getNbBoards() const { return nbBoards; }
+
+  /** called by the solver for each board */
+  bool onSolution(const Board & board);
+
+};
+
+#endif // VOXIGAME_CORE_SOLUTIONCOUNTER_HXX
@@ -0,0 +1,163 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#ifndef VOXIGAME_CORE_SOLVER_HXX
+#define VOXIGAME_CORE_SOLVER_HXX
+
+#include <QVector>
+#include <QPair>
+#include <QSharedPointer>
+#include "core/Coord.hxx"
+#include "core/Board.hxx"
+#include "core/Piece.hxx"
+#include "core/ShapeRegistry.hxx"
+
+/**
+ * A solver filling a board with a given set of pieces: each voxel of the
+ * board that is not in the path (including the windows) has to be covered
+ * by a piece. The problem is described as an exact cover problem (see ExactCover),
+ * with a column per voxel, and a row per placement of a piece (orientation and
+ * translation). Similar pieces are grouped, in order to avoid permutations of
+ * identical pieces.
+ */
+class Solver {
+public:
+  /** a listener is notified for each board found by the solver */
+  class Listener {
+  public:
+    /** destructor */
+    virtual ~Listener() {}
+
+    /** called for each solution. The search stops if it returns false */
+    virtual bool onSolution(const Board & board) = 0;
+  };
+
+  /** an orientation of a piece */
+  class PieceOrientation {
+  public:
+    /** main direction */
+    Direction::Type direction;
+    /** rotation along the main direction */
+    Angle::Type angle;
+    /** minimal corner of the bounded box of the oriented piece located at the origin */
+    Coord corner;
+    /** voxels of the oriented piece, translated to have \p corner at the origin, and sorted */
+    QVector<Coord> voxels;
+  };
+
+private:
+  /** size of the board */
+  unsigned int sizeX;
+  unsigned int sizeY;
+  unsigned int sizeZ;
+
+  /** location of the input window */
+  Coord window1;
+  /** location of the output window */
+  Coord window2;
+
+  /** voxels of the path, not covered by the pieces */
+  QVector<Coord> path;
+
+  /** available pieces: a piece by shape, and its number of copies */
+  QVector<QPair<QSharedPointer<Piece>, unsigned int> > inventory;
+
+  /** true if the exact cover search uses memoization (see ExactCover) */
+  bool memoization;
+
+  /** rotations of the board preserving the problem: image of each voxel index */
+  QVector<QVector<unsigned int> > symmetries;
+
+  /** index of a voxel */
+  inline unsigned int getIndex(const Coord & c) const {
+    return (c.getZ() * sizeY + c.getY()) * sizeX + c.getX();
+  }
+
+  /** return true if the given placement (its sorted voxel indices) has to be kept
+      by the search, i.e. if it is the smallest of its images by the symmetries
+      that restrict it */
+  bool isRepresentative(const QVector<unsigned int> & voxels, int shape, int restrictedShape,
+			int restrictedVoxel) const;
+
+public:
+  /** constructor. The windows are added to the path */
+  Solver(unsigned int x, unsigned int y, unsigned int z,
+	 const Coord & w1, const Coord & w2,
+	 const QVector<Coord> & p = QVector<Coord>());
+
+  /** constructor from an existing board: the free voxels are the path, and
+      the pieces of the board are the available pieces */
+  Solver(const Board & board);
+
+  /** size of the board */
+  inline unsigned int getSizeX() const { return sizeX; }
+  inline unsigned int getSizeY() const { return sizeY; }
+  inline unsigned int getSizeZ() const { return sizeZ; }
+
+  /** location of the windows */
+  inline const Coord & getWindow1() const { return window1; }
+  inline const Coord & getWindow2() const { return window2; }
+
+  /** voxels of the path (including the windows) */
+  inline const QVector<Coord> & getPath() const { return path; }
+
+  /** enable or disable the memoization of the dead ends during the search */
+  inline Solver & setMemoization(bool m) {
+    memoization = m;
+    return *this;
+  }
+
+  /** set the rotations of the board that preserve the problem (the box, the
+      windows and the path), given by the image of each voxel index
+      (x + sizeX * (y + sizeY * z)). The search breaks these symmetries: the
+      placements of a piece available once are restricted to one by class of
+      symmetric placements (or, without such a piece, the placements covering a
+      voxel with symmetries). Each solution is still found up to a symmetry, but
+      two symmetric solutions may be found when a placement is its own image */
+  inline Solver & setSymmetries(const QVector<QVector<unsigned int> > & s) {
+    symmetries = s;
+    return *this;
+  }
+
+  /** add copies of a piece in the available pieces */
+  Solver & addPiece(const Piece & piece, unsigned int count = 1);
+
+  /** number of available shapes */
+  inline unsigned int getNbShapes() const { return inventory.size(); }
+
+  /** find the boards, and notify the listener for each of them. Return the
+      number of boards found */
+  unsigned int solve(Listener & listener) const;
+
+  /** find a board. Return false if no board has been found */
+  bool solve(Board & board) const;
+
+  /** return the distinct orientations of the given piece (at most 24) */
+  static QVector<PieceOrientation> getOrientations(const Piece & piece);
+
+  /** return the distinct orientations of the given shape (at most 24) */
+  static QVector<PieceOrientation> getOrientations(const ShapeRegistry & shapes, unsigned int shape);
+
+};
+
+#endif // VOXIGAME_CORE_SOLVER_HXX
@@ -0,0 +1,88 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#ifndef VOXIGAME_CORE_STABILITYANALYZER_HXX
+#define VOXIGAME_CORE_STABILITYANALYZER_HXX
+
+#include <QVector>
+#include "core/Coord.hxx"
+class Board;
+
+/**
+ * The stability analyzer detects the sets of pieces of a board that can
+ * be translated together in one of the six directions. For each direction,
+ * it builds the graph where an arc (i, j) means that the piece i cannot move
+ * without the piece j, since a voxel of i touches a voxel of j along the
+ * direction. If the board does not allow pieces outside, a virtual node
+ * (the wall) blocks the pieces touching the border.
+ *
+ * A set of pieces can be translated iff it is closed in this graph and does
+ * not contain the wall. Every closed set contains a sink of the graph of the
+ * strongly connected components, thus these sinks are the minimal movable
+ * groups. The analysis is linear in the number of voxels and contacts.
+ */
+class StabilityAnalyzer {
+private:
+  /** number of pieces */
+  unsigned int nbPieces;
+
+  /** index of the piece of each slot of the board (see Board::Handle) */
+  QVector<unsigned int> indices;
+
+  /** arcs of the blocking graph, for each direction (compressed rows, with
+      \p nbPieces + 1 nodes, the last one is the wall) */
+  QVector<unsigned int> first[6];
+  QVector<unsigned int> targets[6];
+
+  /** minimal movable groups, for each direction */
+  QVector<QVector<unsigned int> > groups[6];
+
+  /** build the blocking graph of the given direction */
+  void buildGraph(const Board & board, Direction::Type d);
+
+  /** compute the strongly connected components of the graph of the given
+      direction, and store the sinks as minimal groups */
+  void computeGroups(Direction::Type d);
+
+public:
+  /** constructor: analyze the given board */
+  StabilityAnalyzer(const Board & board);
+
+  /** return the minimal groups of pieces (indices in the board) that can
+      be translated together in the given direction */
+  inline const QVector<QVector<unsigned int> > & getMovableGroups(Direction::Type d) const {
+    Q_ASSERT(d != Direction::Static);
+    return groups[d];
+  }
+
+  /** return the smallest group of pieces (indices in the board) that has to
+      move with the given piece in the given direction, or an empty group if
+      the piece is blocked by the border of the board */
+  QVector<unsigned int> getMovableClosure(unsigned int piece, Direction::Type d) const;
+
+  /** return true if no set of pieces can be translated */
+  bool isStable() const;
+
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+
+#ifndef VOXIGAME_CORE_TRANSPOSITIONTABLE_HXX
+#define VOXIGAME_CORE_TRANSPOSITIONTABLE_HXX
+
+#include <QVector>
+#include <QAtomicInteger>
+
+/**
+ * A fixed-size hash table of board states (64-bit hashes, see Board::getHash
+ * and Board::getCanonicalHash), with a small payload (a value and a depth),
+ * shared by several threads. The table is split into buckets of 4 entries;
+ * a key is stored in the bucket given by its low bits. When the bucket is
+ * full, the entry with the smallest depth is replaced.
+ *
+ * No lock is taken. An entry stores its payload and the key xored with the
+ * payload: an entry written by two threads at the same time, or replaced
+ * during a lookup, does not match its key anymore, and is seen as empty.
+ * Two concurrent insertions of the same key may use two entries; a lookup
+ * returns the first one. A lookup concurrent with the insertion of the same
+ * key may miss it.
+ *
+ * The keys are only hashes: two distinct boards with the same hash are
+ * considered as the same one.
+ */
+class TranspositionTable {
+public:
+  /** number of entries of a bucket */
+  static const unsigned int bucketSize = 4;
+
+  /** maximal depth stored in the table (larger depths are truncated) */
+  static const unsigned int maxDepth = 0x7FFFFFFF;
+
+private:
+  /** an entry of the table: the key xored with the payload, and the payload (0 if empty) */
+  class Entry {
+  public:
+    QAtomicInteger<quint64> key;
+    /** valid flag (1 bit), depth (31 bits) and value (32 bits) */
+    QAtomicInteger<quint64> data;
+    Entry() : key(0), data(0) { }
+  };
+
+  /** entries, bucket by bucket */
+  QVector<Entry> entries;
+
+  /** first entry (entries are accessed without detaching the vector) */
+  Entry * table;
+
+  /** mask of the bucket index */
+  quint64 mask;
+
+  /** valid flag of the payload */
+  static const quint64 validData = (quint64)1 << 63;
+
+  /** payload of an entry */
+  static inline quint64 getData(quint32 value, unsigned int depth) {
+    return validData | (quint64)(depth < maxDepth ? depth : maxDepth) << 32 | value;
+  }
+
+  /** read the given entry. Return false if it is empty or does not correspond to the given key */
+  static inline bool read(const Entry & entry, quint64 key, quint64 & data) {
+    data = entry.data.loadAcquire();
+    return ((data & validData) != 0) && ((entry.key.loadAcquire() ^ data) == key);
+  }
+
+  /** write the given entry */
+  static inline void write(Entry & entry, quint64 key, quint64 data) {
+    entry.key.storeRelease(key ^ data);
+    entry.data.storeRelease(data);
+  }
+
+  /** depth of a payload */
+  static inline unsigned int getDepth(quint64 data) {
+    return (data >> 32) & maxDepth;
+  }
+
+  Q_DISABLE_COPY(TranspositionTable);
+
+public:
+  /** constructor: a table with 2^\p log2Buckets buckets */
+  TranspositionTable(unsigned int log2Buckets = 16);
+
+  /** number of entries of the table */
+  inline unsigned int getNbEntries() const { return entries.size(); }
+
+  /** insert or update the given key. Return true if the key was not in the table.
+      Several concurrent insertions of the same key may return true */
+  bool insert(quint64 key, quint32 value = 0, unsigned int depth = 0);
+
+  /** find the given key. Return false if it is not in the table */
+  bool find(quint64 key, quint32 & value, unsigned int & depth) const;
+
+  /** return true if the given key is in the table */
+  inline bool contains(quint64 key) const {
+    quint32 value;
+    unsigned int depth;
+    return find(key, value, depth);
+  }
+
+  /** remove all the entries (not thread-safe) */
+  void clear();
+
+};
+
+#endif // VOXIGAME_CORE_TRANSPOSITIONTABLE_HXX
@@ -34,6 +34,7 @@
 #include <QMap>
 #include "core/Board.hxx"
 #include "core/AbstractPiece.hxx"
+#include "core/ShapeRegistry.hxx"
 
 /** a class to generate manuals from a board */
 class Manual {
@@ -49,6 +50,10 @@ private:
   /** the board described by the manual */
   const Board & board;
 
+  /** shapes of the drawn pieces. Their faces and edges are computed once
+      by shape and orientation, and shared by all the drawings */
+  mutable ShapeRegistry shapes;
+
   /** if true, all the levels are subdivised in separated steps */
   bool substep;
   /** number of columns per page */
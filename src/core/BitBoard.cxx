@@ -0,0 +1,245 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+#include "core/BitBoard.hxx"
+#include "core/Piece.hxx"
+#include <algorithm>
+
+BitBoard::BitBoard(const Box & b) : box(b),
+				    nbWordsX((b.getSizeX() + 63) / 64),
+				    words(nbWordsX * b.getSizeY() * b.getSizeZ(), 0) {
+}
+
+quint64 BitBoard::getWord(const Mask & mask, unsigned int offset) {
+  Mask::const_iterator w = std::lower_bound(mask.begin(), mask.end(), Word(offset));
+  if ((w != mask.end()) && ((*w).offset == offset))
+    return (*w).bits;
+  else
+    return 0;
+}
+
+BitBoard & BitBoard::set(const Mask & mask) {
+  for(Mask::const_iterator w = mask.begin(); w != mask.end(); ++w)
+    words[(*w).offset] |= (*w).bits;
+  return *this;
+}
+
+BitBoard & BitBoard::reset(const Mask & mask) {
+  for(Mask::const_iterator w = mask.begin(); w != mask.end(); ++w)
+    words[(*w).offset] &= ~(*w).bits;
+  return *this;
+}
+
+BitBoard & BitBoard::clear() {
+  words.fill(0);
+  return *this;
+}
+
+BitBoard::Mask BitBoard::getMask(const Piece & piece) const {
+  const QVector<Coord> & v = piece.getVoxels();
+  return getMask(v.constData(), v.size(), Coord(0, 0, 0));
+}
+
+BitBoard::Mask BitBoard::getMask(const Coord * coords, unsigned int nb, const Coord & t) const {
+  Mask voxels;
+  for(unsigned int i = 0; i != nb; ++i) {
+    const Coord cc = coords[i] + t;
+    if (box.contains(cc))
+      voxels.push_back(Word(getWordOffset(cc), getBit(cc)));
+  }
+
+  // merge the voxels of a same word
+  std::sort(voxels.begin(), voxels.end());
+  Mask result;
+  for(Mask::const_iterator v = voxels.begin(); v != voxels.end(); ++v)
+    if (!result.isEmpty() && (result.back().offset == (*v).offset))
+      result.back().bits |= (*v).bits;
+    else
+      result.push_back(*v);
+
+  return result;
+}
+
+bool BitBoard::intersects(const Mask & mask) const {
+  for(Mask::const_iterator w = mask.begin(); w != mask.end(); ++w)
+    if ((words[(*w).offset] & (*w).bits) != 0)
+      return true;
+  return false;
+}
+
+bool BitBoard::isFreeForMove(const Mask & mask, Direction::Type d) const {
+  const unsigned int sizeY = box.getSizeY();
+  const unsigned int sizeZ = box.getSizeZ();
+  const unsigned int rowStep = nbWordsX;
+  const unsigned int sliceStep = nbWordsX * sizeY;
+
+  for(Mask::const_iterator w = mask.begin(); w != mask.end(); ++w) {
+    const unsigned int offset = (*w).offset;
+    const quint64 bits = (*w).bits;
+
+    if ((d == Direction::Xplus) || (d == Direction::Xminus)) {
+      const unsigned int wx = offset % nbWordsX;
+      quint64 shifted;
+      quint64 carry;
+      unsigned int carryOffset;
+      bool hasCarryWord;
+      if (d == Direction::Xplus) {
+	shifted = bits << 1;
+	carry = bits >> 63;
+	carryOffset = offset + 1;
+	hasCarryWord = wx + 1 < nbWordsX;
+      }
+      else {
+	shifted = bits >> 1;
+	carry = bits << 63;
+	carryOffset = offset - 1;
+	hasCarryWord = wx != 0;
+      }
+      // voxels entering the current word
+      if ((words[offset] & shifted & ~bits) != 0)
+	return false;
+      // voxels entering the next word
+      if ((carry != 0) && hasCarryWord &&
+	  ((words[carryOffset] & carry & ~getWord(mask, carryOffset)) != 0))
+	return false;
+    }
+    else {
+      const unsigned int row = offset / nbWordsX;
+      unsigned int target;
+      switch(d) {
+      case Direction::Yplus:
+	if ((row % sizeY) + 1 >= sizeY) continue;
+	target = offset + rowStep;
+	break;
+      case Direction::Yminus:
+	if ((row % sizeY) == 0) continue;
+	target = offset - rowStep;
+	break;
+      case Direction::Zplus:
+	if ((row / sizeY) + 1 >= sizeZ) continue;
+	target = offset + sliceStep;
+	break;
+      case Direction::Zminus:
+	if ((row / sizeY) == 0) continue;
+	target = offset - sliceStep;
+	break;
+      default:
+	return true;
+      }
+      if ((words[target] & bits & ~getWord(mask, target)) != 0)
+	return false;
+    }
+  }
+
+  return true;
+}
+
+/** extend the seeds along the propagators inside a word, in both directions
+    (occluded fill using a logarithmic number of shifts) */
+static inline quint64 fillWord(quint64 seeds, quint64 propagators) {
+  quint64 up = seeds;
+  quint64 down = seeds;
+  quint64 pu = propagators;
+  quint64 pd = propagators;
+  for(unsigned int shift = 1; shift != 64; shift <<= 1) {
+    up |= pu & (up << shift);
+    pu &= pu << shift;
+    down |= pd & (down >> shift);
+    pd &= pd >> shift;
+  }
+  return (up | down) & propagators;
+}
+
+bool BitBoard::fillFree(QVector<quint64> & reached, const Coord * targets, unsigned int nb) const {
+  const unsigned int sizeY = box.getSizeY();
+  const unsigned int sizeZ = box.getSizeZ();
+  const unsigned int rowStep = nbWordsX;
+  const unsigned int sliceStep = nbWordsX * sizeY;
+  const unsigned int nbWords = words.size();
+
+  // forward and backward sweeps: each word collects the reached voxels
+  // of its neighbours, then is filled along its row
+  bool changed = true;
+  bool all = false;
+  for(bool forward = true; changed; forward = !forward) {
+    changed = false;
+    for(unsigned int i = 0; i != nbWords; ++i) {
+      const unsigned int offset = forward ? i : nbWords - 1 - i;
+      const quint64 free = ~words[offset] & getValidBits(offset % nbWordsX);
+      if (free == 0)
+	continue;
+      const unsigned int wx = offset % nbWordsX;
+      const unsigned int row = offset / nbWordsX;
+      const unsigned int y = row % sizeY;
+      const unsigned int z = row / sizeY;
+
+      quint64 r = reached[offset];
+      if (wx != 0)
+	r |= reached[offset - 1] >> 63;
+      if (wx + 1 != nbWordsX)
+	r |= reached[offset + 1] << 63;
+      if (y != 0)
+	r |= reached[offset - rowStep];
+      if (y + 1 != sizeY)
+	r |= reached[offset + rowStep];
+      if (z != 0)
+	r |= reached[offset - sliceStep];
+      if (z + 1 != sizeZ)
+	r |= reached[offset + sliceStep];
+
+      r = fillWord(r & free, free);
+      if ((r & ~reached[offset]) != 0) {
+	reached[offset] |= r;
+	changed = true;
+      }
+    }
+
+    all = true;
+    for(const Coord * t = targets; all && (t != targets + nb); ++t)
+      all = (reached[getWordOffset(*t)] & getBit(*t)) != 0;
+    if (all && (nb != 0))
+      return true;
+  }
+
+  return all && (nb != 0);
+}
+
+bool BitBoard::hasFreePath(const Coord & c1, const Coord & c2) const {
+  if (get(c1) || get(c2))
+    return false;
+  BitBoard reached(box);
+  return getFreeComponent(c1, reached, &c2, 1);
+}
+
+BitBoard BitBoard::getFreeComponent(const Coord & c) const {
+  BitBoard result(box);
+  if (!get(c))
+    getFreeComponent(c, result, NULL, 0);
+  return result;
+}
+
+bool BitBoard::getFreeComponent(const Coord & c, BitBoard & component, const Coord * targets, unsigned int nb) const {
+  Q_ASSERT((component.box == box) && !get(c));
+  component.clear();
+  component.set(c);
+  return fillFree(component.words, targets, nb);
+}
@@ -19,61 +19,40 @@
 
  *****************************************************************************/
 
+#include <algorithm>
 #include "core/Board.hxx"
 #include "core/PieceFactory.hxx"
+#include "core/StabilityAnalyzer.hxx"
 #include <QtXml/QDomElement>
 #include <QtXml/QDomDocument>
 #include <QFile>
 #include <QTextStream>
 
 
-Board::Board(const Board & b) : box(b.box),
-				allowIntersections(b.allowIntersections),
-				allowOutside(b.allowOutside),
-				window1(b.window1), window2(b.window2),
-				face1(b.face1), face2(b.face2) {
-
-  cells = new QVector<QSharedPointer<Piece> >[box.volume()];
-
-  const QVector<QSharedPointer<Piece> > & ps = b.getPieces();
-  for(QVector<QSharedPointer<Piece> >::const_iterator p = ps.begin(); p != ps.end(); ++p)
-    addPiece(**p);
-}
-
-Board & Board::operator=(const Board & b) {
-  box = b.box;
-  allowIntersections = b.allowIntersections;
-  allowOutside = b.allowOutside;
-  window1 = b.window1;
-  window2 = b.window2;
-  face1 = b.face1;
-  face2 = b.face2;
-
-  if (cells != NULL)
-    delete[] cells;
-
-  cells = new QVector<QSharedPointer<Piece> >[box.volume()];
-
-  const QVector<QSharedPointer<Piece> > & ps = b.getPieces();
-  for(QVector<QSharedPointer<Piece> >::const_iterator p = ps.begin(); p != ps.end(); ++p)
-    addPiece(**p);
-
-  return *this;
-}
+const quint32 Board::noSlot;
 
 Board::Board(unsigned int x, unsigned int y, unsigned int z,
              const Coord & w1, const Coord & w2,
 	     const Direction::Type & f1, const Direction::Type & f2,
 	     bool aI, bool aO)
   : box(x, y, z),
+    lastGeneration(0),
+    firstPiece(noSlot), lastPiece(noSlot),
+    firstFree(noSlot), lastFree(noSlot),
+    nbPieces(0),
+    cells(box.volume(), 0),
+    occupied(box),
+    overlapped(box),
+    freeSpace(occupied),
+    hash(0),
     allowIntersections(aI),
     allowOutside(aO),
     window1(w1), window2(w2),
-    face1(f1), face2(f2)
+    face1(f1), face2(f2),
+    undoEnabled(false)
 {
 
   Q_ASSERT((x > 0) && (y > 0) && (z > 0));
-  cells = new QVector<QSharedPointer<Piece> >[x * y * z];
 
   if (!box.inBorder(w1)) {
     qWarning("Warning: the input window is not in the border of the board");
@@ -127,12 +106,102 @@ Board & Board::addPiece(const Piece & b) {
       if (getNbPieces(*c) != 0)
 	throw ExceptionIntersection();
   }
-  pieces.push_back(QSharedPointer<Piece>(b.clone()));
-  addInCells(pieces.back());
+  appendPiece(QSharedPointer<Piece>(b.clone()));
 
   return *this;
 }
 
+void Board::appendPiece(const QSharedPointer<Piece> & piece) {
+  const quint32 slot = (firstFree == noSlot) ? getNbSlots() : firstFree;
+  const quint32 previous = lastPiece;
+  insertPiece(slot, previous, piece);
+  record(Operation(Operation::Add, slot, previous, Direction::Static, piece, generations[slot]));
+}
+
+void Board::linkSlot(quint32 slot, quint32 previous, quint32 & first, quint32 & last) {
+  const quint32 next = (previous == noSlot) ? first : nextSlots[previous];
+  previousSlots[slot] = previous;
+  nextSlots[slot] = next;
+  if (previous == noSlot)
+    first = slot;
+  else
+    nextSlots[previous] = slot;
+  if (next == noSlot)
+    last = slot;
+  else
+    previousSlots[next] = slot;
+}
+
+void Board::unlinkSlot(quint32 slot, quint32 & first, quint32 & last) {
+  const quint32 previous = previousSlots[slot];
+  const quint32 next = nextSlots[slot];
+  if (previous == noSlot)
+    first = next;
+  else
+    nextSlots[previous] = next;
+  if (next == noSlot)
+    last = previous;
+  else
+    previousSlots[next] = previous;
+}
+
+void Board::insertPiece(quint32 slot, quint32 previous, const QSharedPointer<Piece> & piece) {
+  const Piece & p = *piece;
+  if (slot == getNbSlots()) {
+    shapeIds.push_back(0);
+    orientations.push_back(0);
+    locations.push_back(Coord(0, 0, 0));
+    boxes.push_back(Box());
+    pieces.push_back(QSharedPointer<Piece>());
+    masks.push_back(BitBoard::Mask());
+    generations.push_back(0);
+    nextSlots.push_back(noSlot);
+    previousSlots.push_back(noSlot);
+  }
+  else
+    unlinkSlot(slot, firstFree, lastFree);
+
+  shapeIds[slot] = shapes.add(p);
+  orientations[slot] = Orientation::get(p.getDirection(), p.getAngle());
+  locations[slot] = p.getLocation();
+  boxes[slot] = p.getBoundedBox();
+  pieces[slot] = piece;
+  linkSlot(slot, previous, firstPiece, lastPiece);
+  ++nbPieces;
+
+  addInCells(slot + 1);
+}
+
+void Board::erasePiece(quint32 slot) {
+  removeFromCells(slot + 1);
+
+  // the slot is reused by the next addition
+  unlinkSlot(slot, firstPiece, lastPiece);
+  linkSlot(slot, noSlot, firstFree, lastFree);
+  pieces[slot].clear();
+  generations[slot] = ++lastGeneration;
+  --nbPieces;
+}
+
+void Board::translatePiece(quint32 slot, Direction::Type d) {
+  removeFromCells(slot + 1);
+  locations[slot] += d;
+  boxes[slot].translate(d);
+  // the object may be shared with the copies of the board and the journal
+  QSharedPointer<Piece> piece((*pieces[slot]).clone());
+  (*piece).move(d);
+  pieces[slot] = piece;
+  addInCells(slot + 1);
+}
+
+QVector<QSharedPointer<Piece> > Board::getPieces() const {
+  QVector<QSharedPointer<Piece> > result;
+  result.reserve(nbPieces);
+  for(quint32 slot = firstPiece; slot != noSlot; slot = nextSlots[slot])
+    result.push_back(pieces[slot]);
+  return result;
+}
+
 Board & Board::addPattern(const Pattern & p) {
   if (!allowOutside && !box.contains(p.getBoundedBox())) {
     throw ExceptionOutside();
@@ -153,43 +222,59 @@ Board & Board::addPattern(const Pattern & p) {
 
   for(QVector<QSharedPointer<Piece> >::const_iterator piece = newPieces.begin();
       piece != newPieces.end(); ++piece) {
-    pieces.push_back(QSharedPointer<Piece>((**piece).clone()));
-
-    addInCells(pieces.back());
+    appendPiece(*piece);
   }
 
   return *this;
 }
 
 
-void Board::isAvailableLocationForMove(const const_iterator & i,
-                                       Direction::Type d) const
+MoveStatus::Type Board::getMoveStatus(const const_iterator & i,
+				      Direction::Type d) const
 {
-  QSharedPointer<Piece> newp((*i).clone());
+  const unsigned int id = i.getSlot();
+  const Box & b = boxes[id];
 
-  (*newp).move(d);
-  Q_ASSERT((*newp).nbVoxels() == (*i).nbVoxels());
+  if (!allowOutside && !box.contains(b.getTranslate(d)))
+    return MoveStatus::Outside;
 
-  if (!allowOutside && !box.contains((*newp).getBoundedBox())) {
-    throw ExceptionOutside();
-  }
+  if (allowIntersections)
+    return MoveStatus::Ok;
 
-  if (!allowIntersections) {
-    for(Piece::const_iterator c = (*newp).begin(); c != (*newp).end(); ++c)
-      if (!isEmpty(*c, i)) {
-	throw ExceptionIntersection();
-      }
-  }
+  if (box.contains(b))
+    return occupied.isFreeForMove(masks[id], d) ?
+      MoveStatus::Ok : MoveStatus::Intersection;
+
+  // the piece is partly outside of the board: the cells of the piece itself are
+  // seen as empty, thus only the entering voxels may fail
+  const Coord * v = getOffsets(id);
+  const Coord t = locations[id] + d;
+  for(unsigned int k = 0; k != getNbVoxels(id); ++k)
+    if (!isEmpty(v[k] + t, i))
+      return MoveStatus::Intersection;
 
+  return MoveStatus::Ok;
+}
+
+void Board::isAvailableLocationForMove(const const_iterator & i,
+                                       Direction::Type d) const
+{
+  switch(getMoveStatus(i, d)) {
+  case MoveStatus::Outside:
+    throw ExceptionOutside();
+  case MoveStatus::Intersection:
+    throw ExceptionIntersection();
+  default:
+    break;
+  }
 }
 
 Board & Board::movePiece(const iterator & i, Direction::Type d)
 {
   isAvailableLocationForMove(i, d);
 
-  removeFromCells(*(i.it));
-  (*i).move(d);
-  addInCells(*(i.it));
+  translatePiece(i.getSlot(), d);
+  record(Operation(Operation::Move, i.getSlot(), noSlot, d));
 
   return *this;
 
@@ -197,25 +282,17 @@ Board & Board::movePiece(const iterator & i, Direction::Type d)
 
 
 bool Board::isInsidePiece(const const_iterator & i) const {
-  return box.contains((*i).getBoundedBox());
+  return box.contains(boxes[i.getSlot()]);
 }
 
 bool Board::hasIntersectionPiece(const const_iterator & i) const {
-  for(Piece::const_iterator c = (*i).begin(); c != (*i).end(); ++c)
-    if (!isEmpty(*c, i))
-      return true;
-  return false;
+  return overlapped.intersects(masks[getCellId(i) - 1]);
 }
 
 bool Board::isMovablePiece(const const_iterator & i) const {
-  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
-    try {
-      isAvailableLocationForMove(i, d);
+  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d)
+    if (getMoveStatus(i, d) == MoveStatus::Ok)
       return true;
-    }
-    catch (...) {
-    }
-  }
   return false;
 }
 
@@ -223,7 +300,7 @@ bool Board::isMovablePiece(const const_iterator & i) const {
 
 
 bool Board::isStaticAndValid() const {
-  const_iterator e(pieces.end());
+  const_iterator e = end();
   for(const_iterator it = begin(); it != e; ++it) {
     if (!isInsidePiece(it))
       return false;
@@ -236,8 +313,12 @@ bool Board::isStaticAndValid() const {
   return true;
 }
 
+bool Board::isStableAndValid() const {
+  return isValid() && StabilityAnalyzer(*this).isStable();
+}
+
 bool Board::isValid() const {
-  const_iterator e(pieces.end());
+  const_iterator e = end();
   for(const_iterator it = begin(); it != e; ++it) {
     if (!isInsidePiece(it))
       return false;
@@ -249,87 +330,243 @@ bool Board::isValid() const {
 }
 
 Board & Board::removePiece(const iterator & i) {
-  // remove from cells
-  removeFromCells(*(i.it));
+  const quint32 slot = i.getSlot();
+  const QSharedPointer<Piece> piece = getPiece(slot);
+  const quint32 previous = previousSlots[slot];
+  const quint32 generation = generations[slot];
 
-  // remove it from the list
-  pieces.erase(i.it);
+  erasePiece(slot);
+  record(Operation(Operation::Remove, slot, previous, Direction::Static, piece, generation));
 
   return *this;
 }
 
-void Board::removeFromCells(QSharedPointer<Piece> & p) {
-  for(Piece::const_iterator c = (*p).begin(); c != (*p).end(); ++c) {
-    Coord cc = *c;
+void Board::record(const Operation & o) {
+  if (!undoEnabled && transactions.isEmpty())
+    return;
+  if (transactions.isEmpty())
+    undoSteps.push_back(journal.size());
+  journal.push_back(o);
+  // the operations of a transaction may be rolled back
+  if (transactions.isEmpty())
+    redoSteps.clear();
+}
+
+void Board::apply(const Operation & o) {
+  switch(o.type) {
+  case Operation::Add:
+    insertPiece(o.slot, o.previous, o.piece);
+    generations[o.slot] = o.generation;
+    break;
+  case Operation::Move:
+    translatePiece(o.slot, o.direction);
+    break;
+  case Operation::Remove:
+    erasePiece(o.slot);
+    break;
+  }
+}
+
+void Board::revert(const Operation & o) {
+  switch(o.type) {
+  case Operation::Add:
+    erasePiece(o.slot);
+    break;
+  case Operation::Move:
+    translatePiece(o.slot, -o.direction);
+    break;
+  case Operation::Remove:
+    insertPiece(o.slot, o.previous, o.piece);
+    generations[o.slot] = o.generation;
+    break;
+  }
+}
+
+void Board::revertJournal(unsigned int size) {
+  while((unsigned int)journal.size() > size) {
+    revert(journal.back());
+    journal.pop_back();
+  }
+}
+
+void Board::clearJournal() {
+  journal.clear();
+  undoSteps.clear();
+  redoSteps.clear();
+  transactions.clear();
+}
+
+void Board::beginTransaction() {
+  transactions.push_back(journal.size());
+}
+
+void Board::commitTransaction() {
+  if (transactions.isEmpty())
+    throw Exception("No transaction to commit");
+  const unsigned int first = transactions.back();
+  transactions.pop_back();
+  if (!transactions.isEmpty())
+    return;
+
+  // the top-level transaction is an undo step
+  if (first != (unsigned int)journal.size())
+    redoSteps.clear();
+  if (!undoEnabled)
+    journal.resize(first);
+  else if (first != (unsigned int)journal.size())
+    undoSteps.push_back(first);
+}
+
+void Board::rollbackTransaction() {
+  if (transactions.isEmpty())
+    throw Exception("No transaction to rollback");
+  revertJournal(transactions.back());
+  transactions.pop_back();
+}
+
+void Board::setUndoEnabled(bool u) {
+  undoEnabled = u;
+  if (!undoEnabled && transactions.isEmpty())
+    clearJournal();
+}
+
+void Board::undo() {
+  if (!canUndo())
+    throw Exception("Nothing to undo");
+  const unsigned int first = undoSteps.back();
+  undoSteps.pop_back();
+  redoSteps.push_back(journal.mid(first));
+  revertJournal(first);
+}
+
+void Board::redo() {
+  if (!canRedo())
+    throw Exception("Nothing to redo");
+  const QVector<Operation> step = redoSteps.back();
+  redoSteps.pop_back();
+  undoSteps.push_back(journal.size());
+  for(QVector<Operation>::const_iterator o = step.begin(); o != step.end(); ++o) {
+    apply(*o);
+    journal.push_back(*o);
+  }
+}
+
+quint64 Board::getVoxelKey(const Coord & c) {
+  quint64 v = ((quint64)(c.getX() & 0x1FFFFF) << 42) | ((quint64)(c.getY() & 0x1FFFFF) << 21) | (quint64)(c.getZ() & 0x1FFFFF);
+  v = (v ^ (v >> 30)) * 0xBF58476D1CE4E5B9ull;
+  v = (v ^ (v >> 27)) * 0x94D049BB133111EBull;
+  return v ^ (v >> 31);
+}
+
+quint64 Board::getPieceKey(quint64 sum) {
+  sum = (sum ^ (sum >> 33)) * 0xFF51AFD7ED558CCDull;
+  sum = (sum ^ (sum >> 33)) * 0xC4CEB9FE1A85EC53ull;
+  return sum ^ (sum >> 33);
+}
+
+void Board::removeFromCells(quint32 id) {
+  const Coord * v = getOffsets(id - 1);
+  const Coord & t = locations[id - 1];
+  const unsigned int nb = getNbVoxels(id - 1);
+  quint64 sum = 0;
+  for(unsigned int k = 0; k != nb; ++k) {
+    const Coord cc = v[k] + t;
+    sum += getVoxelKey(cc);
     if (box.contains(cc)) {
-      QVector<QSharedPointer<Piece> > & cList = getCell(cc);
-      int cListPos = cList.indexOf(p);
-      if (cListPos == -1)
+      const unsigned int offset = getCellOffset(cc);
+      quint32 & cell = cells[offset];
+      if (cell == id) {
+	cell = 0;
+	occupied.reset(cc);
+	freeSpace.release(cc);
+      }
+      else if (cell == overlapCell) {
+	QVector<quint32> & cList = overlaps[offset];
+	int cListPos = cList.indexOf(id);
+	if (cListPos == -1)
+	  throw ExceptionInternalError();
+	cList.erase(cList.begin() + cListPos);
+	if (cList.size() == 1) {
+	  cell = cList.front();
+	  overlaps.remove(offset);
+	  overlapped.reset(cc);
+	}
+      }
+      else
 	throw ExceptionInternalError();
-      cList.erase(cList.begin() + cListPos);
     }
   }
+  hash ^= getPieceKey(sum);
+  masks[id - 1].clear();
 }
 
-void Board::addInCells(QSharedPointer<Piece> & p) {
-  for(Piece::const_iterator c = (*p).begin(); c != (*p).end(); ++c) {
-    Coord cc = *c;
+void Board::addInCells(quint32 id) {
+  const Coord * v = getOffsets(id - 1);
+  const Coord & t = locations[id - 1];
+  const unsigned int nb = getNbVoxels(id - 1);
+  quint64 sum = 0;
+  for(unsigned int k = 0; k != nb; ++k) {
+    const Coord cc = v[k] + t;
+    sum += getVoxelKey(cc);
     if (box.contains(cc)) {
-      getCell(cc).push_back(p);
+      const unsigned int offset = getCellOffset(cc);
+      quint32 & cell = cells[offset];
+      if (cell == 0) {
+	cell = id;
+	occupied.set(cc);
+	freeSpace.use(cc);
+      }
+      else if (cell == overlapCell)
+	overlaps[offset].push_back(id);
+      else {
+	QVector<quint32> & cList = overlaps[offset];
+	cList.push_back(cell);
+	cList.push_back(id);
+	cell = overlapCell;
+	overlapped.set(cc);
+      }
     }
   }
+
+  hash ^= getPieceKey(sum);
+
+  if ((quint32)masks.size() < id)
+    masks.resize(id);
+  masks[id - 1] = occupied.getMask(v, nb, t);
+}
+
+QVector<quint32> Board::getCellIds(unsigned int offset) const {
+  const quint32 id = cells[offset];
+  if (id == overlapCell)
+    return overlaps.value(offset);
+  QVector<quint32> result;
+  if (id != 0)
+    result.push_back(id);
+  return result;
+}
+
+QVector<QSharedPointer<Piece> > Board::getPieces(unsigned int x, unsigned int y, unsigned int z) const {
+  QVector<QSharedPointer<Piece> > result;
+  const Coord c(x, y, z);
+  if (!box.contains(c))
+    return result;
+
+  const QVector<quint32> ids = getCellIds(getCellOffset(c));
+  for(QVector<quint32>::const_iterator id = ids.begin(); id != ids.end(); ++id)
+    result.push_back(getPiece(*id - 1));
+  return result;
 }
 
 
 bool Board::isEmpty(const Coord & c, const const_iterator & i) const {
   if (!box.contains(c))
     return true;
-  const QVector<QSharedPointer<Piece> > & cc = getCell(c);
-  const unsigned int nb = cc.size();
-  if (nb == 0)
-    return true;
-  else {
-    if (nb != 1)
-      return false;
-    else {
-      return (cc.front() == *(i.it));
-    }
-  }
+  const quint32 id = cells[getCellOffset(c)];
+  return (id == 0) || (id == getCellId(i));
 }
 
 bool Board::hasPathBetweenWindows() const {
-  if ((getNbPieces(window1) != 0) || (getNbPieces(window2) != 0))
-    return false;
-
-  QVector<Coord> open;
-  bool seen[box.getSizeX()][box.getSizeY()][box.getSizeZ()];
-  for(unsigned int x = 0; x != box.getSizeX(); ++x)
-    for(unsigned int y = 0; y != box.getSizeY(); ++y)
-      for(unsigned int z = 0; z != box.getSizeZ(); ++z)
-        seen[x][y][z] = false;
-
-  open.push_back(window1);
-  seen[window1.getX()][window1.getY()][window1.getZ()] = true;
-
-  while(open.size() != 0) {
-    Coord c = open.back();
-    open.pop_back();
-    if (c == window2)
-      return true;
-    else {
-      for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
-        Coord cc = c + d;
-        if (box.contains(cc) &&
-            !seen[cc.getX()][cc.getY()][cc.getZ()] &&
-            getNbPieces(cc) == 0) {
-          seen[cc.getX()][cc.getY()][cc.getZ()] = true;
-          open.push_back(cc);
-        }
-      }
-    }
-  }
-
-  return false;
+  return freeSpace.areConnected(window1, window2);
 }
 
 
@@ -391,17 +628,107 @@ bool Board::operator==(const Board & board) const {
       !(window1 == board.window1) || !(window2 == board.window2) || (getNbPieces() != board.getNbPieces()))
     return false;
   // check pieces
-  for(const_iterator p = pieces.begin(); p != pieces.end(); ++p)
+  for(const_iterator p = begin(); p != end(); ++p)
     if (!board.hasPiece(*p))
       return false;
   // double check to handle duplicated pieces
-  for(const_iterator p = board.pieces.begin(); p != board.pieces.end(); ++p)
+  for(const_iterator p = board.begin(); p != board.end(); ++p)
     if (!hasPiece(*p))
       return false;
   return true;
 }
 
 
+/** apply a rotation, then a mirror along the x axis if \p mirror is true */
+static inline Coord getSymmetric(const Coord & c, const Angle::Type & a,
+				 const Direction::Type & d, bool mirror) {
+  Coord r = c.getTransform(a, d);
+  if (mirror)
+    r.setX(-r.getX());
+  return r;
+}
+
+/** apply a rotation (and a mirror) to a direction */
+static inline Direction::Type getSymmetric(const Direction::Type & direction, const Angle::Type & a,
+					   const Direction::Type & d, bool mirror) {
+  if (direction == Direction::Static)
+    return direction;
+  const Coord v = getSymmetric(Coord(0, 0, 0) + direction, a, d, mirror);
+  for(Direction::Type r = Direction::Xplus; r != Direction::Static; ++r)
+    if (Coord(0, 0, 0) + r == v)
+      return r;
+  return Direction::Static;
+}
+
+QVector<qint32> Board::getCanonicalForm(bool mirrors) const {
+  // sorted voxels of each piece
+  QVector<QVector<Coord> > voxels;
+  for(quint32 slot = firstPiece; slot != noSlot; slot = nextSlots[slot]) {
+    QVector<Coord> v;
+    const Coord * o = getOffsets(slot);
+    for(unsigned int k = 0; k != getNbVoxels(slot); ++k)
+      v.push_back(o[k] + locations[slot]);
+    voxels.push_back(v);
+  }
+
+  QVector<qint32> result;
+  for(unsigned int m = 0; m != (mirrors ? 2 : 1); ++m)
+    for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+      Angle::Type a = Angle::A0;
+      do {
+	// the transformed box starts from the origin
+	const Coord c1 = getSymmetric(box.getCorner1(), a, d, m == 1);
+	const Coord c2 = getSymmetric(box.getCorner2(), a, d, m == 1);
+	const Coord t(-qMin(c1.getX(), c2.getX()), -qMin(c1.getY(), c2.getY()), -qMin(c1.getZ(), c2.getZ()));
+
+	QVector<qint32> form;
+	form << qAbs(c2.getX() - c1.getX()) + 1 << qAbs(c2.getY() - c1.getY()) + 1 << qAbs(c2.getZ() - c1.getZ()) + 1;
+	form << allowIntersections << allowOutside;
+	const Coord w1 = getSymmetric(window1, a, d, m == 1) + t;
+	const Coord w2 = getSymmetric(window2, a, d, m == 1) + t;
+	form << w1.getX() << w1.getY() << w1.getZ() << getSymmetric(face1, a, d, m == 1);
+	form << w2.getX() << w2.getY() << w2.getZ() << getSymmetric(face2, a, d, m == 1);
+
+	// pieces, sorted by voxels
+	QVector<QVector<qint32> > ps;
+	for(QVector<QVector<Coord> >::const_iterator p = voxels.begin(); p != voxels.end(); ++p) {
+	  QVector<Coord> v;
+	  for(QVector<Coord>::const_iterator c = (*p).begin(); c != (*p).end(); ++c)
+	    v.push_back(getSymmetric(*c, a, d, m == 1) + t);
+	  std::sort(v.begin(), v.end());
+	  QVector<qint32> piece;
+	  piece << v.size();
+	  for(QVector<Coord>::const_iterator c = v.begin(); c != v.end(); ++c)
+	    piece << (*c).getX() << (*c).getY() << (*c).getZ();
+	  ps.push_back(piece);
+	}
+	std::sort(ps.begin(), ps.end());
+	for(QVector<QVector<qint32> >::const_iterator p = ps.begin(); p != ps.end(); ++p)
+	  form << *p;
+
+	if (result.isEmpty() || (form < result))
+	  result = form;
+	++a;
+      } while(a != Angle::A0);
+    }
+
+  return result;
+}
+
+quint64 Board::getCanonicalHash(bool mirrors) const {
+  const QVector<qint32> form = getCanonicalForm(mirrors);
+  // FNV-1a, followed by a final mixing of the bits
+  quint64 h = 0xCBF29CE484222325ull;
+  for(QVector<qint32>::const_iterator v = form.begin(); v != form.end(); ++v) {
+    h ^= (quint32)*v;
+    h *= 0x100000001B3ull;
+  }
+  h = (h ^ (h >> 33)) * 0xFF51AFD7ED558CCDull;
+  h = (h ^ (h >> 33)) * 0xC4CEB9FE1A85EC53ull;
+  return h ^ (h >> 33);
+}
+
+
 bool Board::checkInternalMemoryState() const {
   // check validity
   if (!allowIntersections || !allowOutside)
@@ -412,22 +739,92 @@ bool Board::checkInternalMemoryState() const {
 	return false;
     }
 
+  // check the lists of slots
+  const unsigned int nbSlots = getNbSlots();
+  if ((shapeIds.size() != (int)nbSlots) || (orientations.size() != (int)nbSlots) ||
+      (locations.size() != (int)nbSlots) || (boxes.size() != (int)nbSlots) ||
+      (pieces.size() != (int)nbSlots) || (masks.size() != (int)nbSlots) ||
+      (nextSlots.size() != (int)nbSlots) || (previousSlots.size() != (int)nbSlots))
+    return false;
+  unsigned int nbUsed = 0;
+  for(quint32 slot = firstPiece, previous = noSlot; slot != noSlot; previous = slot, slot = nextSlots[slot], ++nbUsed)
+    if ((nbUsed == nbSlots) || pieces[slot].isNull() || (previousSlots[slot] != previous) ||
+	((nextSlots[slot] == noSlot) != (slot == lastPiece)))
+      return false;
+  unsigned int nbFree = 0;
+  for(quint32 slot = firstFree, previous = noSlot; slot != noSlot; previous = slot, slot = nextSlots[slot], ++nbFree)
+    if ((nbFree == nbSlots) || !pieces[slot].isNull() || (previousSlots[slot] != previous) ||
+	((nextSlots[slot] == noSlot) != (slot == lastFree)))
+      return false;
+  if ((nbUsed != nbPieces) || (nbUsed + nbFree != nbSlots))
+    return false;
+
+  // check if the table of pieces describes the piece objects
+  for(const_iterator p = begin(); p != end(); ++p) {
+    const unsigned int i = p.getSlot();
+    if (!((*p).getLocation() == locations[i]) || !((*p).getBoundedBox() == boxes[i]) ||
+	(shapes.getId(*p) != shapeIds[i]) ||
+	(Orientation::get((*p).getDirection(), (*p).getAngle()) != orientations[i]))
+      return false;
+    QVector<Coord> v;
+    const Coord * o = getOffsets(i);
+    for(unsigned int k = 0; k != getNbVoxels(i); ++k)
+      v.push_back(o[k] + locations[i]);
+    QVector<Coord> expected = (*p).getVoxels();
+    std::sort(v.begin(), v.end());
+    std::sort(expected.begin(), expected.end());
+    if (v != expected)
+      return false;
+  }
+
   // check if all the pieces are correctly referenced in the data structure
-  for(const_iterator p = pieces.begin(); p != pieces.end(); ++p)
+  for(const_iterator p = begin(); p != end(); ++p)
     for(Piece::const_iterator c = (*p).begin(); c != (*p).end(); ++c) {
       Q_ASSERT(box.contains(*c));
-      if (!getCell(*c).contains(*(p.getIt())))
+      if (!getCellIds(getCellOffset(*c)).contains(getCellId(p)))
 	return false;
     }
 
+  // check if the free space is up-to-date
+  if (!freeSpace.hasSameComponents(FreeSpace(occupied)))
+    return false;
+
+  // check if the hash is up-to-date
+  quint64 h = 0;
+  for(const_iterator p = begin(); p != end(); ++p) {
+    quint64 sum = 0;
+    for(Piece::const_iterator c = (*p).begin(); c != (*p).end(); ++c)
+      sum += getVoxelKey(*c);
+    h ^= getPieceKey(sum);
+  }
+  if (h != hash)
+    return false;
+
+  // check if the masks of the pieces are up-to-date
+  for(const_iterator p = begin(); p != end(); ++p) {
+    const BitBoard::Mask & mask = masks[getCellId(p) - 1];
+    const BitBoard::Mask expected = occupied.getMask(*p);
+    if (mask.size() != expected.size())
+      return false;
+    for(int w = 0; w != mask.size(); ++w)
+      if ((mask[w].offset != expected[w].offset) || (mask[w].bits != expected[w].bits))
+	return false;
+  }
+
   // check if all the cells have valid objects
   Box::const_iterator e = box.end();
   for(Box::const_iterator cc = box.begin(); cc != e; ++cc) {
-    const QVector<QSharedPointer<Piece> > & cell = getCell(*cc);
-    for(QVector<QSharedPointer<Piece> >::const_iterator p = cell.begin(); p != cell.end(); ++p) {
-      if (!pieces.contains(*p))
+    const unsigned int offset = getCellOffset(*cc);
+    const QVector<quint32> ids = getCellIds(offset);
+    if ((cells[offset] == overlapCell) && (ids.size() < 2))
+      return false;
+    if ((occupied.get(*cc) != (cells[offset] != 0)) ||
+	(overlapped.get(*cc) != (cells[offset] == overlapCell)))
+      return false;
+    for(QVector<quint32>::const_iterator id = ids.begin(); id != ids.end(); ++id) {
+      if ((*id == 0) || (*id > nbSlots) || pieces[*id - 1].isNull())
 	return false;
-      if (!(**p).isUsing(*cc))
+      if (!(*getPiece(*id - 1)).isUsing(*cc))
 	return false;
     }
   }
@@ -552,19 +949,35 @@ bool Board::load(QDomDocument & elem, const QString & name) {
   if (face2 == Direction::Static)
     face2 = getBorderSide(w2, false);
 
-  if (cells != NULL)
-    delete [] cells;
-  cells = new QVector<QSharedPointer<Piece> >[box.volume()];
-
+  cells.fill(0, box.volume());
+  overlaps.clear();
+  occupied = BitBoard(box);
+  overlapped = BitBoard(box);
+  masks.clear();
+  freeSpace = FreeSpace(occupied);
+  hash = 0;
+
+  shapes = ShapeRegistry();
+  shapeIds.clear();
+  orientations.clear();
+  locations.clear();
+  boxes.clear();
   pieces.clear();
-  for(QVector<QSharedPointer<Piece> >::const_iterator p = newPieces.begin(); p != newPieces.end(); ++p) {
-    pieces.push_back(*p);
-    addInCells(pieces.back());
-  }
+  generations.clear();
+  nextSlots.clear();
+  previousSlots.clear();
+  firstPiece = lastPiece = noSlot;
+  firstFree = lastFree = noSlot;
+  nbPieces = 0;
+  for(QVector<QSharedPointer<Piece> >::const_iterator p = newPieces.begin(); p != newPieces.end(); ++p)
+    appendPiece(*p);
 
   for(QVector<Pattern>::const_iterator p = patterns.begin(); p != patterns.end(); ++p)
     addPattern(*p);
 
+  // a loaded board has no history
+  clearJournal();
+
   return true;
 }
 
@@ -573,7 +986,7 @@ QVector<Coord> Board::getFreeCells() const {
 
   Box::const_iterator e = box.end();
   for(Box::const_iterator cc = box.begin(); cc != e; ++cc)
-    if (getCell(*cc).isEmpty())
+    if (cells[getCellOffset(*cc)] == 0)
       result.push_back(*cc);
 
   return result;
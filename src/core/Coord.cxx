@@ -251,3 +251,68 @@ Angle fromString(const QString & s) {
 } // namespace Angle
 
 
+namespace Orientation {
+
+const int matrices[24][9] = {
+  {  1,  0,  0,  0,  1,  0,  0,  0,  1 }, // Xplus, A0
+  {  1,  0,  0,  0,  0, -1,  0,  1,  0 }, // Xplus, A90
+  {  1,  0,  0,  0, -1,  0,  0,  0, -1 }, // Xplus, A180
+  {  1,  0,  0,  0,  0,  1,  0, -1,  0 }, // Xplus, A270
+  { -1,  0,  0,  0, -1,  0,  0,  0,  1 }, // Xminus, A0
+  { -1,  0,  0,  0,  0,  1,  0,  1,  0 }, // Xminus, A90
+  { -1,  0,  0,  0,  1,  0,  0,  0, -1 }, // Xminus, A180
+  { -1,  0,  0,  0,  0, -1,  0, -1,  0 }, // Xminus, A270
+  {  0,  0,  1,  1,  0,  0,  0,  1,  0 }, // Yplus, A0
+  {  0,  1,  0,  1,  0,  0,  0,  0, -1 }, // Yplus, A90
+  {  0,  0, -1,  1,  0,  0,  0, -1,  0 }, // Yplus, A180
+  {  0, -1,  0,  1,  0,  0,  0,  0,  1 }, // Yplus, A270
+  {  0,  0,  1, -1,  0,  0,  0, -1,  0 }, // Yminus, A0
+  {  0,  1,  0, -1,  0,  0,  0,  0,  1 }, // Yminus, A90
+  {  0,  0, -1, -1,  0,  0,  0,  1,  0 }, // Yminus, A180
+  {  0, -1,  0, -1,  0,  0,  0,  0, -1 }, // Yminus, A270
+  {  0,  1,  0,  0,  0,  1,  1,  0,  0 }, // Zplus, A0
+  {  0,  0, -1,  0,  1,  0,  1,  0,  0 }, // Zplus, A90
+  {  0, -1,  0,  0,  0, -1,  1,  0,  0 }, // Zplus, A180
+  {  0,  0,  1,  0, -1,  0,  1,  0,  0 }, // Zplus, A270
+  {  0, -1,  0,  0,  0,  1, -1,  0,  0 }, // Zminus, A0
+  {  0,  0,  1,  0,  1,  0, -1,  0,  0 }, // Zminus, A90
+  {  0,  1,  0,  0,  0, -1, -1,  0,  0 }, // Zminus, A180
+  {  0,  0, -1,  0, -1,  0, -1,  0,  0 }  // Zminus, A270
+};
+
+const unsigned char compositions[24][24] = {
+  {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23 },
+  {  1,  2,  3,  0,  7,  4,  5,  6, 19, 16, 17, 18, 21, 22, 23, 20, 13, 14, 15, 12, 11,  8,  9, 10 },
+  {  2,  3,  0,  1,  6,  7,  4,  5, 12, 13, 14, 15,  8,  9, 10, 11, 22, 23, 20, 21, 18, 19, 16, 17 },
+  {  3,  0,  1,  2,  5,  6,  7,  4, 21, 22, 23, 20, 19, 16, 17, 18,  9, 10, 11,  8, 15, 12, 13, 14 },
+  {  4,  5,  6,  7,  0,  1,  2,  3, 14, 15, 12, 13, 10, 11,  8,  9, 18, 19, 16, 17, 22, 23, 20, 21 },
+  {  5,  6,  7,  4,  3,  0,  1,  2, 17, 18, 19, 16, 23, 20, 21, 22, 11,  8,  9, 10, 13, 14, 15, 12 },
+  {  6,  7,  4,  5,  2,  3,  0,  1, 10, 11,  8,  9, 14, 15, 12, 13, 20, 21, 22, 23, 16, 17, 18, 19 },
+  {  7,  4,  5,  6,  1,  2,  3,  0, 23, 20, 21, 22, 17, 18, 19, 16, 15, 12, 13, 14,  9, 10, 11,  8 },
+  {  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,  0,  1,  2,  3,  4,  5,  6,  7 },
+  {  9, 10, 11,  8, 15, 12, 13, 14,  3,  0,  1,  2,  5,  6,  7,  4, 21, 22, 23, 20, 19, 16, 17, 18 },
+  { 10, 11,  8,  9, 14, 15, 12, 13, 20, 21, 22, 23, 16, 17, 18, 19,  6,  7,  4,  5,  2,  3,  0,  1 },
+  { 11,  8,  9, 10, 13, 14, 15, 12,  5,  6,  7,  4,  3,  0,  1,  2, 17, 18, 19, 16, 23, 20, 21, 22 },
+  { 12, 13, 14, 15,  8,  9, 10, 11, 22, 23, 20, 21, 18, 19, 16, 17,  2,  3,  0,  1,  6,  7,  4,  5 },
+  { 13, 14, 15, 12, 11,  8,  9, 10,  1,  2,  3,  0,  7,  4,  5,  6, 19, 16, 17, 18, 21, 22, 23, 20 },
+  { 14, 15, 12, 13, 10, 11,  8,  9, 18, 19, 16, 17, 22, 23, 20, 21,  4,  5,  6,  7,  0,  1,  2,  3 },
+  { 15, 12, 13, 14,  9, 10, 11,  8,  7,  4,  5,  6,  1,  2,  3,  0, 23, 20, 21, 22, 17, 18, 19, 16 },
+  { 16, 17, 18, 19, 20, 21, 22, 23,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+  { 17, 18, 19, 16, 23, 20, 21, 22, 11,  8,  9, 10, 13, 14, 15, 12,  5,  6,  7,  4,  3,  0,  1,  2 },
+  { 18, 19, 16, 17, 22, 23, 20, 21,  4,  5,  6,  7,  0,  1,  2,  3, 14, 15, 12, 13, 10, 11,  8,  9 },
+  { 19, 16, 17, 18, 21, 22, 23, 20, 13, 14, 15, 12, 11,  8,  9, 10,  1,  2,  3,  0,  7,  4,  5,  6 },
+  { 20, 21, 22, 23, 16, 17, 18, 19,  6,  7,  4,  5,  2,  3,  0,  1, 10, 11,  8,  9, 14, 15, 12, 13 },
+  { 21, 22, 23, 20, 19, 16, 17, 18,  9, 10, 11,  8, 15, 12, 13, 14,  3,  0,  1,  2,  5,  6,  7,  4 },
+  { 22, 23, 20, 21, 18, 19, 16, 17,  2,  3,  0,  1,  6,  7,  4,  5, 12, 13, 14, 15,  8,  9, 10, 11 },
+  { 23, 20, 21, 22, 17, 18, 19, 16, 15, 12, 13, 14,  9, 10, 11,  8,  7,  4,  5,  6,  1,  2,  3,  0 }
+};
+
+const unsigned char inverses[24] = {
+  0, 3, 2, 1, 4, 5, 6, 7, 16, 9, 22, 13, 18, 11, 20, 15, 8, 21, 12, 19, 14, 17, 10, 23
+};
+
+const unsigned char rotations[6] = {
+  1, 3, 21, 17, 11, 13
+};
+
+} // namespace Orientation
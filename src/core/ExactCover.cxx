@@ -0,0 +1,215 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#include "core/ExactCover.hxx"
+
+const unsigned int ExactCover::noGroup;
+const int ExactCover::maxFailures;
+
+/** mix the bits of a 64-bit integer (splitmix64 finalizer) */
+static inline quint64 mix(quint64 v) {
+  v += 0x9E3779B97F4A7C15ull;
+  v = (v ^ (v >> 30)) * 0xBF58476D1CE4E5B9ull;
+  v = (v ^ (v >> 27)) * 0x94D049BB133111EBull;
+  return v ^ (v >> 31);
+}
+
+quint64 ExactCover::getColumnKey(unsigned int c) {
+  return mix(c);
+}
+
+quint64 ExactCover::getGroupKey(unsigned int g, unsigned int nb) {
+  return mix(((quint64)(g + 1) << 32) | nb);
+}
+
+ExactCover::ExactCover(unsigned int nbColumns) : sizes(nbColumns + 1, 0),
+						 covered(nbColumns + 1, false),
+						 nbSolutions(0), stopped(false),
+						 memoization(false), state(0) {
+  // root and column headers
+  for(unsigned int i = 0; i != nbColumns + 1; ++i) {
+    left.push_back(i == 0 ? nbColumns : i - 1);
+    right.push_back(i == nbColumns ? 0 : i + 1);
+    up.push_back(i);
+    down.push_back(i);
+    column.push_back(i);
+    row.push_back(noGroup);
+  }
+}
+
+unsigned int ExactCover::addRow(const QVector<unsigned int> & columns, unsigned int group) {
+  Q_ASSERT((group == noGroup) || (group < (unsigned int)bounds.size()));
+  const unsigned int r = groups.size();
+  const unsigned int first = left.size();
+  groups.push_back(group);
+  firsts.push_back(first);
+  hidden.push_back(false);
+  if (group != noGroup)
+    groupRows[group].push_back(r);
+
+  for(int i = 0; i != columns.size(); ++i) {
+    const unsigned int c = columns[i] + 1;
+    Q_ASSERT(c < (unsigned int)sizes.size());
+    const unsigned int n = left.size();
+    left.push_back(i == 0 ? first + columns.size() - 1 : n - 1);
+    right.push_back(i + 1 == columns.size() ? first : n + 1);
+    up.push_back(up[c]);
+    down.push_back(c);
+    down[up[c]] = n;
+    up[c] = n;
+    column.push_back(c);
+    row.push_back(r);
+    ++sizes[c];
+  }
+
+  return r;
+}
+
+void ExactCover::cover(unsigned int c) {
+  covered[c] = true;
+  state ^= getColumnKey(c);
+  right[left[c]] = right[c];
+  left[right[c]] = left[c];
+  for(unsigned int i = down[c]; i != c; i = down[i])
+    for(unsigned int j = right[i]; j != i; j = right[j]) {
+      down[up[j]] = down[j];
+      up[down[j]] = up[j];
+      --sizes[column[j]];
+    }
+}
+
+void ExactCover::uncover(unsigned int c) {
+  for(unsigned int i = up[c]; i != c; i = up[i])
+    for(unsigned int j = left[i]; j != i; j = left[j]) {
+      ++sizes[column[j]];
+      down[up[j]] = j;
+      up[down[j]] = j;
+    }
+  right[left[c]] = c;
+  left[right[c]] = c;
+  covered[c] = false;
+  state ^= getColumnKey(c);
+}
+
+void ExactCover::hideGroup(unsigned int g, QVector<unsigned int> & rows) {
+  for(QVector<unsigned int>::const_iterator r = groupRows[g].begin(); r != groupRows[g].end(); ++r) {
+    if (hidden[*r])
+      continue;
+    // a row using a covered column is already removed from the other columns
+    const unsigned int first = firsts[*r];
+    bool available = !covered[column[first]];
+    for(unsigned int j = right[first]; available && (j != first); j = right[j])
+      available = !covered[column[j]];
+    if (!available)
+      continue;
+
+    hidden[*r] = true;
+    rows.push_back(*r);
+    unsigned int j = first;
+    do {
+      down[up[j]] = down[j];
+      up[down[j]] = up[j];
+      --sizes[column[j]];
+      j = right[j];
+    } while(j != first);
+  }
+}
+
+void ExactCover::unhideRows(const QVector<unsigned int> & rows) {
+  for(int i = rows.size() - 1; i >= 0; --i) {
+    const unsigned int first = firsts[rows[i]];
+    unsigned int j = left[first];
+    do {
+      ++sizes[column[j]];
+      down[up[j]] = j;
+      up[down[j]] = j;
+      j = left[j];
+    } while(j != left[first]);
+    hidden[rows[i]] = false;
+  }
+}
+
+void ExactCover::searchFrom(Listener & listener) {
+  if (right[0] == 0) {
+    ++nbSolutions;
+    if (!listener.onSolution(solution))
+      stopped = true;
+    return;
+  }
+
+  if (memoization && failures.contains(state))
+    return;
+  const unsigned int nbPrevious = nbSolutions;
+
+  // the column with the smallest number of rows
+  unsigned int c = right[0];
+  for(unsigned int j = right[c]; j != 0; j = right[j])
+    if (sizes[j] < sizes[c])
+      c = j;
+  if (sizes[c] == 0)
+    return;
+
+  cover(c);
+  for(unsigned int r = down[c]; (r != c) && !stopped; r = down[r]) {
+    const unsigned int g = groups[row[r]];
+    if ((g != noGroup) && (used[g] == bounds[g]))
+      continue;
+    if (g != noGroup) {
+      state ^= getGroupKey(g, used[g]);
+      ++used[g];
+      state ^= getGroupKey(g, used[g]);
+    }
+    solution.push_back(row[r]);
+    for(unsigned int j = right[r]; j != r; j = right[j])
+      cover(column[j]);
+    // the other rows of an exhausted group are removed
+    QVector<unsigned int> hiddenRows;
+    if ((g != noGroup) && (used[g] == bounds[g]))
+      hideGroup(g, hiddenRows);
+
+    searchFrom(listener);
+
+    unhideRows(hiddenRows);
+    for(unsigned int j = left[r]; j != r; j = left[j])
+      uncover(column[j]);
+    solution.pop_back();
+    if (g != noGroup) {
+      state ^= getGroupKey(g, used[g]);
+      --used[g];
+      state ^= getGroupKey(g, used[g]);
+    }
+  }
+  uncover(c);
+
+  if (memoization && !stopped && (nbSolutions == nbPrevious) && (failures.size() < maxFailures))
+    failures.insert(state);
+}
+
+unsigned int ExactCover::search(Listener & listener) {
+  nbSolutions = 0;
+  stopped = false;
+  solution.clear();
+  failures.clear();
+  searchFrom(listener);
+  return nbSolutions;
+}
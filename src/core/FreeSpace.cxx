@@ -0,0 +1,249 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#include "core/FreeSpace.hxx"
+#include <QHash>
+#include <QtAlgorithms>
+
+FreeSpace::FreeSpace(const BitBoard & u) : used(u),
+					   nodes(u.getBox().volume()),
+					   nbComponents(0) {
+  build();
+}
+
+void FreeSpace::build() {
+  const Box & box = used.getBox();
+  const unsigned int rowStep = box.getSizeX();
+  const unsigned int sliceStep = rowStep * box.getSizeY();
+  const unsigned int nbWordsX = used.getNbWordsX();
+  const QVector<quint64> & words = used.getWords();
+  const unsigned int unset = nodes.size();
+
+  parent.fill(unset, nodes.size());
+  for(unsigned int v = 0; v != unset; ++v)
+    if (nodes.at(v) != v)
+      nodes[v] = v;
+  nbComponents = 0;
+
+  // merge each free voxel with its previous free neighbours
+  for(unsigned int w = 0; w != (unsigned int)words.size(); ++w) {
+    const unsigned int row = w / nbWordsX;
+    const unsigned int first = row * rowStep + (w % nbWordsX) * 64;
+    const unsigned int last = qMin(first + 64, (row + 1) * rowStep);
+    const quint64 bits = words[w];
+    for(unsigned int v = first; v != last; ++v) {
+      if ((bits >> (v - first)) & 1)
+	continue;
+      parent[v] = v;
+      ++nbComponents;
+      if ((v % rowStep != 0) && (parent.at(v - 1) != unset) && unite(v, v - 1))
+	--nbComponents;
+      if ((v % sliceStep >= rowStep) && (parent.at(v - rowStep) != unset) && unite(v, v - rowStep))
+	--nbComponents;
+      if ((v >= sliceStep) && (parent.at(v - sliceStep) != unset) && unite(v, v - sliceStep))
+	--nbComponents;
+    }
+  }
+
+  // each free voxel is linked to its root (the roots are the smallest nodes of
+  // their sets), thus the queries are in constant time
+  for(unsigned int v = 0; v != unset; ++v)
+    if ((parent.at(v) != unset) && (parent.at(v) != v))
+      parent[v] = find(parent.at(v));
+}
+
+unsigned int FreeSpace::find(unsigned int n) const {
+  for(unsigned int p = parent.at(n); p != n; p = parent.at(n))
+    n = p;
+  return n;
+}
+
+unsigned int FreeSpace::compress(unsigned int n) {
+  // the shared chunks are only copied when the path is modified
+  for(unsigned int p = parent.at(n); p != n; p = parent.at(n)) {
+    const unsigned int gp = parent.at(p);
+    if (gp != p)
+      parent[n] = gp;
+    n = gp;
+  }
+  return n;
+}
+
+bool FreeSpace::unite(unsigned int n1, unsigned int n2) {
+  const unsigned int r1 = compress(n1);
+  const unsigned int r2 = compress(n2);
+  if (r1 < r2)
+    parent[r2] = r1;
+  else if (r2 < r1)
+    parent[r1] = r2;
+  return r1 != r2;
+}
+
+bool FreeSpace::areLocallyConnected(const Coord & c, const Coord * voxels, unsigned int nb) const {
+  // flood fill in the 3x3x3 neighbourhood, starting from the first voxel
+  const Coord corner(c.getX() - 1, c.getY() - 1, c.getZ() - 1);
+  bool seen[27] = { false };
+  Coord open[27];
+  unsigned int nbOpen = 0;
+  open[nbOpen++] = voxels[0];
+  seen[((voxels[0].getZ() - corner.getZ()) * 3 + (voxels[0].getY() - corner.getY())) * 3
+       + voxels[0].getX() - corner.getX()] = true;
+
+  while(nbOpen != 0) {
+    const Coord v = open[--nbOpen];
+    for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+      const Coord n = v + d;
+      const int x = n.getX() - corner.getX();
+      const int y = n.getY() - corner.getY();
+      const int z = n.getZ() - corner.getZ();
+      if ((x < 0) || (x > 2) || (y < 0) || (y > 2) || (z < 0) || (z > 2))
+	continue;
+      const unsigned int i = (z * 3 + y) * 3 + x;
+      if (!seen[i] && used.getBox().contains(n) && !used.get(n)) {
+	seen[i] = true;
+	open[nbOpen++] = n;
+      }
+    }
+  }
+
+  for(const Coord * v = voxels; v != voxels + nb; ++v)
+    if (!seen[(((*v).getZ() - corner.getZ()) * 3 + ((*v).getY() - corner.getY())) * 3
+	      + (*v).getX() - corner.getX()])
+      return false;
+  return true;
+}
+
+bool FreeSpace::hasSameComponents(const FreeSpace & space) const {
+  const Box & box = getBox();
+  if (!(box == space.getBox()) || (getNbComponents() != space.getNbComponents()))
+    return false;
+
+  // the labels of the two structures are in a one-to-one correspondence
+  QHash<unsigned int, unsigned int> labels;
+  QHash<unsigned int, unsigned int> inverse;
+  Box::const_iterator e = box.end();
+  for(Box::const_iterator c = box.begin(); c != e; ++c) {
+    const unsigned int l1 = getLabel(*c);
+    const unsigned int l2 = space.getLabel(*c);
+    if ((l1 == noComponent) || (l2 == noComponent)) {
+      if (l1 != l2)
+	return false;
+      continue;
+    }
+    QHash<unsigned int, unsigned int>::const_iterator l = labels.find(l1);
+    if (l == labels.end()) {
+      if (inverse.contains(l2))
+	return false;
+      labels.insert(l1, l2);
+      inverse.insert(l2, l1);
+    }
+    else if (*l != l2)
+      return false;
+  }
+  return true;
+}
+
+FreeSpace & FreeSpace::use(const Coord & c) {
+  if (used.get(c))
+    return *this;
+  used.set(c);
+
+  Coord neighbours[6];
+  unsigned int nb = 0;
+  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+    const Coord n = c + d;
+    if (used.getBox().contains(n) && !used.get(n))
+      neighbours[nb++] = n;
+  }
+
+  // the voxel stays in the union-find structure, as a link between the
+  // voxels of its component
+  if (nb == 0)
+    --nbComponents;
+  else if ((nb != 1) && !areLocallyConnected(c, neighbours, nb))
+    split(neighbours, nb);
+
+  return *this;
+}
+
+void FreeSpace::split(Coord * neighbours, unsigned int nb) {
+  // the new components get new nodes
+  if (parent.size() + nb >= 2 * nodes.size()) {
+    build();
+    return;
+  }
+
+  // each part that does not reach the other neighbours is a new component,
+  // the last part keeps the nodes of the initial component
+  BitBoard part(used.getBox());
+  while((nb > 1) && !used.getFreeComponent(neighbours[0], part, neighbours + 1, nb - 1)) {
+    relabel(part);
+    ++nbComponents;
+    unsigned int nbOthers = 0;
+    for(unsigned int i = 1; i != nb; ++i)
+      if (!part.get(neighbours[i]))
+	neighbours[nbOthers++] = neighbours[i];
+    nb = nbOthers;
+  }
+}
+
+void FreeSpace::relabel(const BitBoard & voxels) {
+  const unsigned int node = parent.size();
+  parent.push_back(node);
+
+  const unsigned int rowStep = used.getBox().getSizeX();
+  const unsigned int nbWordsX = voxels.getNbWordsX();
+  const QVector<quint64> & words = voxels.getWords();
+  for(unsigned int w = 0; w != (unsigned int)words.size(); ++w) {
+    const unsigned int first = (w / nbWordsX) * rowStep + (w % nbWordsX) * 64;
+    for(quint64 bits = words[w]; bits != 0; bits &= bits - 1) {
+      const unsigned int v = first + qCountTrailingZeroBits(bits);
+      if (nodes.at(v) != node)
+	nodes[v] = node;
+    }
+  }
+}
+
+FreeSpace & FreeSpace::release(const Coord & c) {
+  if (!used.get(c))
+    return *this;
+  used.reset(c);
+
+  // the old nodes are dropped by a new labeling
+  if (parent.size() >= 2 * nodes.size()) {
+    build();
+    return *this;
+  }
+
+  const unsigned int node = parent.size();
+  nodes[getOffset(c)] = node;
+  parent.push_back(node);
+  ++nbComponents;
+  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+    const Coord n = c + d;
+    if (used.getBox().contains(n) && !used.get(n) && unite(node, nodes.at(getOffset(n))))
+      --nbComponents;
+  }
+
+  return *this;
+}
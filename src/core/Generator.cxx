@@ -0,0 +1,293 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#include <QThread>
+#include <QAtomicInteger>
+#include <QPair>
+#include <QMap>
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+#include "core/Generator.hxx"
+#include "core/Pattern.hxx"
+#include "core/StabilityAnalyzer.hxx"
+
+
+/** an axis chosen randomly */
+static Direction::Type randomAxis(QRandomGenerator & random) {
+  static const Direction::Type axes[3] = { Direction::Xplus, Direction::Yplus, Direction::Zplus };
+  return axes[random.bounded(3)];
+}
+
+
+/** the six directions, in a random order */
+static QVector<Direction::Type> randomDirections(QRandomGenerator & random) {
+  QVector<Direction::Type> result;
+  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d)
+    result.push_back(d);
+  for(int i = result.size() - 1; i > 0; --i)
+    qSwap(result[i], result[random.bounded(i + 1)]);
+  return result;
+}
+
+
+/** the canonical forms of the generated boards, shared by the threads */
+class GeneratedBoards {
+private:
+  QMutex mutex;
+  QSet<QVector<qint32> > forms;
+public:
+  /** add the canonical form of a board. Return false if it was already generated */
+  bool insert(const QVector<qint32> & form) {
+    QMutexLocker locker(&mutex);
+    if (forms.contains(form))
+      return false;
+    forms.insert(form);
+    return true;
+  }
+};
+
+
+/** a thread generating the boards of a shared list of seeds */
+class GeneratorThread : public QThread {
+private:
+  const Generator & generator;
+  QAtomicInteger<unsigned int> & next;
+  unsigned int nbBoards;
+  quint32 seed;
+  /** the generated boards (NULL if the duplicated boards are kept) */
+  GeneratedBoards * generated;
+public:
+  /** generated boards, with their index */
+  QVector<QPair<unsigned int, Board> > boards;
+
+  GeneratorThread(const Generator & g, QAtomicInteger<unsigned int> & n,
+		  unsigned int nb, quint32 s,
+		  GeneratedBoards * gb) : generator(g), next(n), nbBoards(nb), seed(s), generated(gb) {
+  }
+
+protected:
+  void run() {
+    for(unsigned int i = next.fetchAndAddOrdered(1); i < nbBoards; i = next.fetchAndAddOrdered(1)) {
+      Board board;
+      if (generator.generate(board, seed + i) &&
+	  ((generated == NULL) || (*generated).insert(board.getCanonicalForm())))
+	boards.push_back(qMakePair(i, board));
+    }
+  }
+};
+
+
+Generator::Generator(unsigned int sx, unsigned int sy, unsigned int sz,
+		     const Coord & c1, const Direction::Type & f1,
+		     const Coord & c2, const Direction::Type & f2) : sizeX(sx), sizeY(sy), sizeZ(sz),
+								     cell1(c1), face1(f1),
+								     cell2(c2), face2(f2),
+								     minLength(1), maxTries(100),
+								     stable(true), unique(false) {
+  if ((sx == 0) || (sy == 0) || (sz == 0))
+    throw Exception("Empty board");
+  if ((f1 == Direction::Static) || (f2 == Direction::Static))
+    throw Exception("Static direction, not possible");
+  if (!containsCell(c1) || containsCell(c1 + f1))
+    throw Exception("The input window is not in the border of the board");
+  if (!containsCell(c2) || containsCell(c2 + f2))
+    throw Exception("The output window is not in the border of the board");
+  if ((c1 == c2) && (f1 == f2))
+    throw Exception("Two identical windows, not possible");
+}
+
+bool Generator::route(QVector<Coord> & cells, QVector<Direction::Type> & steps,
+		      QRandomGenerator & random) const {
+  QVector<bool> visited(sizeX * sizeY * sizeZ, false);
+  // directions not yet explored for each cell of the current path
+  QVector<QVector<Direction::Type> > choices;
+  unsigned int budget = 64 * sizeX * sizeY * sizeZ;
+
+  cells.clear();
+  steps.clear();
+  cells.push_back(cell1);
+  steps.push_back(-face1);
+  visited[getCellIndex(cell1)] = true;
+  choices.push_back(randomDirections(random));
+
+  while(!cells.isEmpty() && (budget-- != 0)) {
+    const Coord current = cells.back();
+    if (current == cell2) {
+      if ((unsigned int)cells.size() >= minLength) {
+	steps.push_back(face2);
+	return true;
+      }
+      // the path cannot continue after the output cell
+      choices.back().clear();
+    }
+
+    Direction::Type d = Direction::Static;
+    while(!choices.back().isEmpty() && (d == Direction::Static)) {
+      const Direction::Type next = choices.back().back();
+      choices.back().pop_back();
+      if (containsCell(current + next) && !visited[getCellIndex(current + next)])
+	d = next;
+    }
+
+    if (d == Direction::Static) {
+      // backtrack
+      visited[getCellIndex(current)] = false;
+      cells.pop_back();
+      steps.pop_back();
+      choices.pop_back();
+    }
+    else {
+      cells.push_back(current + d);
+      steps.push_back(d);
+      visited[getCellIndex(current + d)] = true;
+      choices.push_back(randomDirections(random));
+    }
+  }
+
+  cells.clear();
+  steps.clear();
+  return false;
+}
+
+Board Generator::build(const QVector<Direction::Type> & steps) const {
+  Board board(3 * sizeX, 3 * sizeY, 3 * sizeZ, getWindow1(), getWindow2(), face1, face2);
+
+  board.addPattern(Pattern::pipe(getCellCenter(cell1), steps));
+
+  return board;
+}
+
+void Generator::fill(Board & board, const QVector<Direction::Type> & axes) const {
+  for(unsigned int z = 0; z != sizeZ; ++z)
+    for(unsigned int y = 0; y != sizeY; ++y)
+      for(unsigned int x = 0; x != sizeX; ++x) {
+	const Coord c(x, y, z);
+	const Direction::Type axis = axes[getCellIndex(c)];
+	// the pieces of a parallelepiped are along its local z axis, oriented
+	// along x (resp. y, z) by the direction y (resp. z, x)
+	if (axis != Direction::Static)
+	  board.addPattern(Pattern::parallelepiped(3, 3, 3, Coord(3 * x, 3 * y, 3 * z),
+						   axis == Direction::Xplus ? Direction::Yplus :
+						   (axis == Direction::Yplus ? Direction::Zplus : Direction::Xplus)));
+      }
+}
+
+bool Generator::isValid(const Board & board) const {
+  return board.isStaticAndValid() &&
+    board.hasPathBetweenWindows() &&
+    (!stable || board.isStableAndValid());
+}
+
+bool Generator::generate(Board & board, quint32 seed) const {
+  QRandomGenerator random(seed);
+  QVector<Coord> cells;
+  QVector<Direction::Type> steps;
+
+  for(unsigned int t = 0; t != maxTries; ++t) {
+    if (!route(cells, steps, random))
+      continue;
+
+    // random axis for the cells outside of the path
+    QVector<Direction::Type> axes(sizeX * sizeY * sizeZ);
+    for(QVector<Direction::Type>::iterator a = axes.begin(); a != axes.end(); ++a)
+      *a = randomAxis(random);
+    for(QVector<Coord>::const_iterator c = cells.begin(); c != cells.end(); ++c)
+      axes[getCellIndex(*c)] = Direction::Static;
+
+    // the cells of the movable groups of pieces get a new axis, a few times.
+    // The path is built once, and the other pieces are reverted after each try
+    Board result = build(steps);
+    for(unsigned int r = 0; r != 4; ++r) {
+      result.beginTransaction();
+      fill(result, axes);
+      if (isValid(result)) {
+	result.commitTransaction();
+	board = result;
+	return true;
+      }
+
+      // the pieces of the movable groups (a single movable piece is also a group)
+      QVector<bool> movable(result.getNbPieces(), false);
+      if (stable) {
+	const StabilityAnalyzer analyzer(result);
+	for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+	  const QVector<QVector<unsigned int> > & groups = analyzer.getMovableGroups(d);
+	  for(QVector<QVector<unsigned int> >::const_iterator g = groups.begin(); g != groups.end(); ++g)
+	    for(QVector<unsigned int>::const_iterator i = (*g).begin(); i != (*g).end(); ++i)
+	      movable[*i] = true;
+	}
+      }
+
+      bool changed = false;
+      unsigned int index = 0;
+      for(Board::const_iterator p = result.begin(); p != result.end(); ++p, ++index)
+	if (movable[index] || (!stable && result.isMovablePiece(p))) {
+	  const Coord & l = (*p).getLocation();
+	  const unsigned int cell = getCellIndex(Coord(l.getX() / 3, l.getY() / 3, l.getZ() / 3));
+	  if (axes[cell] != Direction::Static) {
+	    axes[cell] = randomAxis(random);
+	    changed = true;
+	  }
+	}
+
+      // no movable piece outside of the path: all the other cells get a new axis
+      if (!changed)
+	for(QVector<Direction::Type>::iterator a = axes.begin(); a != axes.end(); ++a)
+	  if (*a != Direction::Static)
+	    *a = randomAxis(random);
+
+      result.rollbackTransaction();
+    }
+  }
+
+  return false;
+}
+
+QVector<Board> Generator::generate(unsigned int nbBoards, unsigned int nbThreads, quint32 seed) const {
+  QAtomicInteger<unsigned int> next(0);
+
+  QSharedPointer<GeneratedBoards> generated;
+  if (unique)
+    generated = QSharedPointer<GeneratedBoards>(new GeneratedBoards());
+
+  QVector<QSharedPointer<GeneratorThread> > threads;
+  for(unsigned int i = 0; i < qMax(1u, nbThreads); ++i)
+    threads.push_back(QSharedPointer<GeneratorThread>(new GeneratorThread(*this, next, nbBoards, seed,
+									  generated.data())));
+  for(QVector<QSharedPointer<GeneratorThread> >::iterator t = threads.begin(); t != threads.end(); ++t)
+    (**t).start();
+
+  // boards ordered by seed
+  QMap<unsigned int, Board> boards;
+  for(QVector<QSharedPointer<GeneratorThread> >::iterator t = threads.begin(); t != threads.end(); ++t) {
+    (**t).wait();
+    for(QVector<QPair<unsigned int, Board> >::const_iterator b = (**t).boards.begin(); b != (**t).boards.end(); ++b)
+      boards.insert((*b).first, (*b).second);
+  }
+
+  QVector<Board> result;
+  for(QMap<unsigned int, Board>::const_iterator b = boards.begin(); b != boards.end(); ++b)
+    result.push_back(*b);
+  return result;
+}
@@ -24,47 +24,59 @@
 #include "core/StraightPiece.hxx"
 #include "core/LPiece.hxx"
 #include "core/GenericPiece.hxx"
+#include "core/BitBoard.hxx"
 
-Pattern::Pattern(const Pattern & p) : Pattern() {
-  *this = p;
+Pattern::Element Pattern::Element::getTransform(const Angle::Type & a,
+						const Direction::Type & d,
+						const Coord & t) const {
+  return Element(piece, Orientation::compose(Orientation::get(d, a), orientation),
+		 location.getTransform(a, d, t));
 }
 
-Pattern& Pattern::operator=(const Pattern& p) {
-  for(QVector<QSharedPointer<Piece> >::const_iterator pp = p.pieces.begin();
-      pp != p.pieces.end(); ++pp)
-    pieces.push_back(QSharedPointer<Piece>((**pp).clone()));
+QVector<Coord> Pattern::Element::getVoxels() const {
+  QVector<Coord> result((*piece).getVoxels());
+  Coord::transform(result.data(), result.size(), Orientation::getAngle(orientation),
+		   Orientation::getDirection(orientation), location);
+  return result;
+}
 
-  return *this;
+Piece * Pattern::Element::createPiece() const {
+  Piece * result = (*piece).clone();
+  (*result).transform(Orientation::getAngle(orientation),
+		      Orientation::getDirection(orientation), location);
+  return result;
 }
 
 Pattern & Pattern::addPiece(const Piece & piece) {
   if (pieces.isEmpty())
     box = piece.getBoundedBox();
   else
-    for(Piece::const_iterator p = piece.begin(); p != piece.end(); ++p)
-      box.add(*p);
-  pieces.push_back(QSharedPointer<Piece>(piece.clone()));
+    box.add(piece.getBoundedBox());
+  pieces.push_back(Element(QSharedPointer<Piece>(piece.clone())));
   return *this;
 }
 
 Pattern & Pattern::addPattern(const Pattern & pattern)
 {
-  QVector<QSharedPointer<Piece> > newPieces = pattern.getPieces();
-  for(QVector<QSharedPointer<Piece> >::const_iterator p = newPieces.begin();
-      p != newPieces.end(); ++p) {
-    addPiece(**p);
-  }
+  if (pattern.pieces.isEmpty())
+    return *this;
+
+  // the pieces are shared, only their transformations are composed
+  if (pieces.isEmpty())
+    box = pattern.getBoundedBox();
+  else
+    box.add(pattern.getBoundedBox());
+  for(QVector<Element>::const_iterator e = pattern.pieces.begin(); e != pattern.pieces.end(); ++e)
+    pieces.push_back((*e).getTransform(pattern.angle, pattern.direction, pattern.location));
   return *this;
 }
 
 QVector<QSharedPointer<Piece> > Pattern::getPieces() const
 {
   QVector<QSharedPointer<Piece> > result;
-  for(QVector<QSharedPointer<Piece> >::const_iterator p = pieces.begin();
-      p != pieces.end(); ++p) {
-    result.push_back(QSharedPointer<Piece>((**p).clone()));
-    (*(result.back())).transform(angle, direction, location);
-  }
+  result.reserve(pieces.size());
+  for(QVector<Element>::const_iterator e = pieces.begin(); e != pieces.end(); ++e)
+    result.push_back(QSharedPointer<Piece>((*e).getTransform(angle, direction, location).createPiece()));
   Q_ASSERT(result.size() == pieces.size());
   return result;
 }
@@ -73,8 +85,33 @@ QVector<QSharedPointer<Piece> > Pattern::getPieces() const
 /** return true if the current pattern contains intersection configurations */
 bool Pattern::hasIntersection() const
 {
-  QVector<QSharedPointer<Piece> >::const_iterator e(pieces.end());
-  for(QVector<QSharedPointer<Piece> >::const_iterator p = pieces.begin(); p != e; ++p)
+  if (pieces.size() < 2)
+    return false;
+
+  quint64 nbVoxels = 0;
+  for(QVector<Element>::const_iterator e = pieces.begin(); e != pieces.end(); ++e)
+    nbVoxels += (*e).nbVoxels();
+
+  // the pieces are added one by one in a bitboard of the pattern
+  if (BitBoard::getNbWords(box) <= nbVoxels) {
+    BitBoard used(box);
+    for(QVector<Element>::const_iterator e = pieces.begin(); e != pieces.end(); ++e) {
+      const QVector<Coord> voxels = (*e).getVoxels();
+      for(QVector<Coord>::const_iterator c = voxels.begin(); c != voxels.end(); ++c)
+	if (used.get(*c))
+	  return true;
+      for(QVector<Coord>::const_iterator c = voxels.begin(); c != voxels.end(); ++c)
+	used.set(*c);
+    }
+    return false;
+  }
+
+  // sparse pattern: pairs of pieces
+  QVector<QSharedPointer<Piece> > local;
+  for(QVector<Element>::const_iterator e = pieces.begin(); e != pieces.end(); ++e)
+    local.push_back(QSharedPointer<Piece>((*e).createPiece()));
+  QVector<QSharedPointer<Piece> >::const_iterator e(local.end());
+  for(QVector<QSharedPointer<Piece> >::const_iterator p = local.begin(); p != e; ++p)
     for(QVector<QSharedPointer<Piece> >::const_iterator p1 = p + 1; p1 != e; ++p1)
       if ((**p).intersect(**p1))
 	return true;
@@ -25,9 +25,12 @@
 #include <QtXml/QDomElement>
 #include <QString>
 #include <QMap>
+#include <QHash>
 #include "core/AbstractPiece.hxx"
+#include "core/BitBoard.hxx"
+#include <algorithm>
 
-Piece::Piece(const QDomElement & elem, const QString & name)
+Piece::Piece(const QDomElement & elem, const QString & name) : cached(false)
 {
   if (elem.isNull())
     throw Exception("NULL Dom element");
@@ -61,100 +64,41 @@ bool Piece::operator==(const Piece & piece) const {
   return (piece.location == location) && (piece.direction == direction) && (piece.angle == angle);
 }
 
+void Piece::updateCache() const {
+  const unsigned int nb = nbVoxels();
+  voxels.resize(nb);
+  for(unsigned int i = 0; i != nb; ++i)
+    voxels[i] = getLocalCoordById(i);
+  Coord::transform(voxels.data(), nb, angle, direction, location);
+  boundedBox = getLocalBoundedBox().transform(angle, direction, location);
+  cached = true;
+}
+
 Piece & Piece::transform(const Angle::Type & a,
                          const Direction::Type & d,
                          const Coord & t)
 {
+  invalidate();
   location.transform(a, d, t);
 
-  direction = Direction::reorient(direction, d);
-
-  // rotation
-  Direction::rotate(direction, d, a);
-  if (direction == d)
-    angle = angle + a;
-  else if (direction == -d)
-    angle = angle + a;
+  const Orientation::Type o = Orientation::compose(Orientation::get(d, a),
+						   Orientation::get(direction, angle));
+  direction = Orientation::getDirection(o);
+  angle = Orientation::getAngle(o);
 
   return *this;
 }
 
 
 Piece & Piece::rotate(Direction::Type d) {
-  if (d == direction) {
-    ++angle;
-    return *this;
-  }
-  if (areOpposite(d, direction)) {
-    --angle;
-    return *this;
-  }
-
-  // (x, y, z) is a direct coordinate system
-  switch(d) {
-  case Direction::Xplus: // y -> z
-    switch(direction) {
-    case Direction::Yplus: direction = Direction::Zplus; --angle; break;
-    case Direction::Zplus: direction = Direction::Yminus; ++angle; break;
-    case Direction::Yminus: direction = Direction::Zminus; ++angle; break;
-    case Direction::Zminus: direction = Direction::Yplus; --angle; break;
-    default:
-      throw Exception();
-    }
-    break;
-  case Direction::Xminus: // z -> y
-    switch(direction) {
-    case Direction::Yplus: direction = Direction::Zminus; ++angle; break;
-    case Direction::Zplus: direction = Direction::Yplus; ++angle; break;
-    case Direction::Yminus: direction = Direction::Zplus; --angle; break;
-    case Direction::Zminus: direction = Direction::Yminus; --angle; break;
-    default:
-      throw Exception();
-    }
-    break;
-  case Direction::Yplus: // z -> x
-    switch(direction) {
-    case Direction::Xplus: direction = Direction::Zminus; ++angle; break;
-    case Direction::Zplus: direction = Direction::Xplus; --angle; break;
-    case Direction::Xminus: direction = Direction::Zplus; --angle; break;
-    case Direction::Zminus: direction = Direction::Xminus; ++angle; break;
-    default:
-      throw Exception();
-    }
-    break;
-  case Direction::Yminus: // x -> z
-    switch(direction) {
-    case Direction::Xplus: direction = Direction::Zplus; ++angle; break;
-    case Direction::Zplus: direction = Direction::Xminus; ++angle; break;
-    case Direction::Xminus: direction = Direction::Zminus; --angle; break;
-    case Direction::Zminus: direction = Direction::Xplus; --angle; break;
-    default:
-      throw Exception();
-    }
-    break;
-  case Direction::Zplus: // x -> y
-    switch(direction) {
-    case Direction::Xplus: direction = Direction::Yplus; --angle; break;
-    case Direction::Yplus: direction = Direction::Xminus; ++angle; break;
-    case Direction::Xminus: direction = Direction::Yminus; ++angle; break;
-    case Direction::Yminus: direction = Direction::Xplus; --angle; break;
-    default:
-      throw Exception();
-    }
-    break;
-  case Direction::Zminus: // y -> x
-    switch(direction) {
-    case Direction::Xplus: direction = Direction::Yminus; ++angle; break;
-    case Direction::Yplus: direction = Direction::Xplus; ++angle; break;
-    case Direction::Xminus: direction = Direction::Yplus; --angle; break;
-    case Direction::Yminus: direction = Direction::Xminus; --angle; break;
-    default:
-      throw Exception();
-    }
-    break;
-  case Direction::Static:
+  if (d == Direction::Static)
     throw Exception();
-  }
+  invalidate();
+
+  const Orientation::Type o = Orientation::compose(Orientation::rotations[d],
+						   Orientation::get(direction, angle));
+  direction = Orientation::getDirection(o);
+  angle = Orientation::getAngle(o);
 
   return *this;
 }
@@ -174,23 +118,131 @@ QDomElement Piece::toXML(QDomDocument & doc) const {
 
 QList<Face> Piece::getFaces() const {
   QList<Face> result;
+  const QVector<Coord> & coords = getVoxels();
+  const Box & b = getBoundedBox();
+
+  // a face is external if the neighbour voxel is not in the piece
+  if (BitBoard::getNbWords(b) <= (quint64)coords.size()) {
+    BitBoard used(b);
+    for(QVector<Coord>::const_iterator v = coords.begin(); v != coords.end(); ++v)
+      used.set(*v);
+    for(QVector<Coord>::const_iterator v = coords.begin(); v != coords.end(); ++v)
+      for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d)
+	if (!used.get(*v + d))
+	  result.push_back(Face(*v, d));
+  }
+  else {
+    // sparse piece: search in the sorted voxels
+    QVector<Coord> sorted(coords);
+    std::sort(sorted.begin(), sorted.end());
+    for(QVector<Coord>::const_iterator v = coords.begin(); v != coords.end(); ++v)
+      for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d)
+	if (!std::binary_search(sorted.begin(), sorted.end(), *v + d))
+	  result.push_back(Face(*v, d));
+  }
 
-  for(const_iterator v = begin(); v != end(); ++v)
-    for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
-      Face face(*v, d);
-      face.invert(); // get the opposite face
-      int fr = result.indexOf(face);
-      if (fr == -1) { // if the opposite face do not exist, add it
-	face.invert();
-	result.push_back(face);
-      }
-      else { // else, remove the opposite face: it's an inner face
-	result.erase(result.begin() + fr);
+  return result;
+}
+
+/**
+   A flat hash table of the edges of a set of faces. Each normalized edge
+   is packed in a 64 bits key, stored with the number of adjacent faces and
+   the direction of the two first ones (open addressing, linear probing).
+   The edges are kept in the insertion order.
+*/
+class EdgeTable {
+private:
+  /** an entry of the table */
+  struct Entry {
+    /** packed edge (0 if the entry is empty) */
+    quint64 key;
+    /** number of adjacent faces */
+    quint8 nbFaces;
+    /** direction of the first adjacent face */
+    quint8 first;
+    /** direction of the second adjacent face */
+    quint8 second;
+  };
+
+  /** entries of the table (a power of two) */
+  QVector<Entry> entries;
+
+  /** distinct edges, in insertion order */
+  QList<Edge> edges;
+
+  /** entry of each edge in \p entries */
+  QVector<quint32> positions;
+
+  /** packed key of a normalized edge: 20 bits by coordinate, 2 bits
+      for the direction, and a flag for the non-empty entries */
+  static inline quint64 getKey(const Edge & e) {
+    const Coord & c = e.getLocation();
+    return ((quint64)1 << 62) |
+      ((quint64)(c.getX() & 0xFFFFF) << 42) | ((quint64)(c.getY() & 0xFFFFF) << 22) |
+      ((quint64)(c.getZ() & 0xFFFFF) << 2) | (quint64)(e.getDirection() >> 1);
+  }
+
+public:
+  /** constructor, for the edges of at most \p nbFaces faces */
+  EdgeTable(unsigned int nbFaces) {
+    unsigned int size = 16;
+    while(size < 8 * nbFaces)
+      size *= 2;
+    Entry empty = { 0, 0, 0, 0 };
+    entries.fill(empty, size);
+    positions.reserve(4 * nbFaces);
+  }
+
+  /** add the edges of the given face */
+  void add(const Face & face) {
+    const quint64 mask = entries.size() - 1;
+    const QList<Edge> fedges = face.getEdges();
+    for(QList<Edge>::const_iterator e = fedges.begin(); e != fedges.end(); ++e) {
+      const Edge edge = (*e).getNormalize();
+      const quint64 key = getKey(edge);
+      quint64 p = (key * Q_UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+      while(true) {
+	Entry & entry = entries[p & mask];
+	if (entry.key == 0) {
+	  entry.key = key;
+	  entry.nbFaces = 1;
+	  entry.first = face.getDirection();
+	  edges.push_back(edge);
+	  positions.push_back(p & mask);
+	  break;
+	}
+	if (entry.key == key) {
+	  if (entry.nbFaces == 1)
+	    entry.second = face.getDirection();
+	  ++entry.nbFaces;
+	  break;
+	}
+	++p;
       }
     }
+  }
 
-  return result;
-}
+  /** return the edges, without the ones between two coplanar faces if
+      \p removeFlatEdges = true */
+  QList<Edge> getEdges(bool removeFlatEdges) const {
+    QList<Edge> result;
+    for(int i = 0; i != edges.size(); ++i) {
+      const Entry & entry = entries[positions[i]];
+      if (entry.nbFaces == 2) {
+	const Direction::Type d1 = (Direction::Type)entry.first;
+	const Direction::Type d2 = (Direction::Type)entry.second;
+	// if the two adjacent faces are not oriented in the same direction, it corresponds to a non-flat edge
+	if ((!removeFlatEdges) || ((d1 != d2) && (d1 != -d2)))
+	  result.push_back(edges[i]);
+      }
+      else {
+	Q_ASSERT(entry.nbFaces > 2);
+	result.push_back(edges[i]);
+      }
+    }
+    return result;
+  }
+};
 
 QPair<QList<Face>, QList<Edge> > Piece::getFacesAndEdges(bool removeFlatEdges) const {
   QPair<QList<Face>, QList<Edge> > result;
@@ -198,33 +250,77 @@ QPair<QList<Face>, QList<Edge> > Piece::getFacesAndEdges(bool removeFlatEdges) c
   // first compute faces
   result.first = getFaces();
 
-  // then compute all edges
-  QMap<Edge, QList<Face> > map;
-  foreach(const Face & face, result.first) {
-    QList<Edge> edges = face.getEdges();
-    for(QList<Edge>::const_iterator e = edges.begin(); e != edges.end(); ++e) {
-      map[(*e).getNormalize()].push_back(face);
-    }
-  }
+  // then compute all edges, with their adjacent faces
+  EdgeTable table(result.first.size());
+  for(QList<Face>::const_iterator f = result.first.begin(); f != result.first.end(); ++f)
+    table.add(*f);
 
   // then get only the non-flat edges
-  for(QMap<Edge, QList<Face> >::iterator e = map.begin(); e != map.end(); ++e) {
-    if ((*e).size() == 2) {
-      const Face & f1 = (*e)[0];
-      const Face & f2 = (*e)[1];
-      // if the two adjacent faces are not oriented in the same direction, it corresponds to a non-flat edge
-      if ((!removeFlatEdges) || ((f1.getDirection() != f2.getDirection()) && (f1.getDirection() != -f2.getDirection())))
-	result.second.push_back(e.key());
-    }
-    else {
-      Q_ASSERT((*e).size() > 2);
-      result.second.push_back(e.key());
-    }
-  }
+  result.second = table.getEdges(removeFlatEdges);
 
   return result;
 }
 
+QList<Face> Piece::getFacesAndEdges(QList<Edge> & edges, QList<Edge> & allEdges) const {
+  const QList<Face> faces = getFaces();
+
+  // a single table for the two lists of edges
+  EdgeTable table(faces.size());
+  for(QList<Face>::const_iterator f = faces.begin(); f != faces.end(); ++f)
+    table.add(*f);
+
+  edges = table.getEdges(true);
+  allEdges = table.getEdges(false);
+
+  return faces;
+}
+
+
+bool Piece::intersect(const Piece & p) const {
+  const Box & b1 = getBoundedBox();
+  const Box & b2 = p.getBoundedBox();
+  if (!b1.intersects(b2))
+    return false;
+
+  const Box common = b1.getIntersection(b2);
+  const QVector<Coord> & v1 = getVoxels();
+  const QVector<Coord> & v2 = p.getVoxels();
+
+  // the voxels of the first piece in a bitboard of the common box
+  if (BitBoard::getNbWords(common) <= (quint64)(v1.size() + v2.size())) {
+    BitBoard used(common);
+    for(QVector<Coord>::const_iterator c = v1.begin(); c != v1.end(); ++c)
+      if (common.contains(*c))
+	used.set(*c);
+    for(QVector<Coord>::const_iterator c = v2.begin(); c != v2.end(); ++c)
+      if (used.get(*c))
+	return true;
+    return false;
+  }
+
+  // sparse pieces: merge of the sorted voxels of the common box
+  QVector<Coord> s1, s2;
+  for(QVector<Coord>::const_iterator c = v1.begin(); c != v1.end(); ++c)
+    if (common.contains(*c))
+      s1.push_back(*c);
+  for(QVector<Coord>::const_iterator c = v2.begin(); c != v2.end(); ++c)
+    if (common.contains(*c))
+      s2.push_back(*c);
+  std::sort(s1.begin(), s1.end());
+  std::sort(s2.begin(), s2.end());
+  QVector<Coord>::const_iterator c1 = s1.begin();
+  QVector<Coord>::const_iterator c2 = s2.begin();
+  while((c1 != s1.end()) && (c2 != s2.end())) {
+    if (*c1 < *c2)
+      ++c1;
+    else if (*c2 < *c1)
+      ++c2;
+    else
+      return true;
+  }
+  return false;
+}
+
 
 bool Piece::isSimilar(const Piece & piece) const {
   const unsigned int n = nbVoxels();
@@ -239,27 +335,74 @@ bool Piece::isSimilar(const Piece & piece) const {
 }
 
 
+QVector<Coord> Piece::getSignature() const {
+  const unsigned int nb = nbVoxels();
+  QVector<Coord> local;
+  local.reserve(nb);
+  for(unsigned int i = 0; i != nb; ++i)
+    local.push_back(getLocalCoordById(i));
+
+  QVector<Coord> result;
+  for(Orientation::Type o = 0; o != Orientation::nbOrientations; ++o) {
+    QVector<Coord> coords(local);
+    Coord::transform(coords.data(), nb, Orientation::getAngle(o), Orientation::getDirection(o));
+    const Coord corner = Box(coords).getCorner1();
+    const Coord shift(-corner.getX(), -corner.getY(), -corner.getZ());
+    for(QVector<Coord>::iterator v = coords.begin(); v != coords.end(); ++v)
+      *v += shift;
+    std::sort(coords.begin(), coords.end());
+    if ((o == 0) || std::lexicographical_compare(coords.begin(), coords.end(),
+						  result.begin(), result.end()))
+      result = coords;
+  }
+
+  return result;
+}
+
+/** hash of a signature (FNV-1a on the coordinates) */
+static quint64 hashSignature(const QVector<Coord> & signature) {
+  quint64 h = Q_UINT64_C(14695981039346656037);
+  for(QVector<Coord>::const_iterator c = signature.begin(); c != signature.end(); ++c) {
+    h = (h ^ (quint64)(quint32)(*c).getX()) * Q_UINT64_C(1099511628211);
+    h = (h ^ (quint64)(quint32)(*c).getY()) * Q_UINT64_C(1099511628211);
+    h = (h ^ (quint64)(quint32)(*c).getZ()) * Q_UINT64_C(1099511628211);
+  }
+  return h;
+}
+
 QMap<AbstractPiece, unsigned int>
 Piece::groupBySimilarity(const QVector<QSharedPointer<Piece> > & pieces) {
-  QMap<AbstractPiece, unsigned int> result;
-
-  for(QVector<QSharedPointer<Piece> >::const_iterator piece = pieces.begin();
-      piece != pieces.end(); ++piece) {
+  // groups, indexed by the hash of their signature
+  QHash<quint64, QList<unsigned int> > groups;
+  QVector<QVector<Coord> > signatures;
+  QVector<unsigned int> firsts;
+  QVector<unsigned int> sizes;
+
+  for(int i = 0; i != pieces.size(); ++i) {
+    const QVector<Coord> signature = (*pieces[i]).getSignature();
+    QList<unsigned int> & candidates = groups[hashSignature(signature)];
     bool found = false;
-    for(QMap<AbstractPiece, unsigned int>::iterator p = result.begin();
-	p != result.end(); ++p)
-      if ((*(p.key())).isSimilar(**piece)) {
-	++(*p);
+    for(QList<unsigned int>::const_iterator g = candidates.begin(); g != candidates.end(); ++g)
+      if (signatures[*g] == signature) {
+	++sizes[*g];
 	found = true;
 	break;
       }
     if (!found) {
-      AbstractPiece local = AbstractPiece((**piece).clone());
-      (*local).resetTransform();
-      result[local] = 1;
+      candidates.push_back(signatures.size());
+      signatures.push_back(signature);
+      firsts.push_back(i);
+      sizes.push_back(1);
     }
   }
 
+  QMap<AbstractPiece, unsigned int> result;
+  for(int g = 0; g != firsts.size(); ++g) {
+    AbstractPiece local = AbstractPiece((*pieces[firsts[g]]).clone());
+    (*local).resetTransform();
+    result[local] = sizes[g];
+  }
+
   return result;
 }
 
@@ -268,17 +411,17 @@ bool Piece::operator<(const Piece & piece) const {
   Box bp = piece.getBoundedBox();
   const unsigned int v = b.volume();
   const unsigned int vp = bp.volume();
-  if (v > vp)
-    return true;
-  else if (v == vp) {
-    if (b.getSizeX() > bp.getSizeX())
-      return true;
-    else {
-      return nbVoxels() > piece.nbVoxels();
-    }
-  }
-  else
-    return false;
+  if (v != vp)
+    return v > vp;
+  if (b.getSizeX() != bp.getSizeX())
+    return b.getSizeX() > bp.getSizeX();
+  if (nbVoxels() != piece.nbVoxels())
+    return nbVoxels() > piece.nbVoxels();
+
+  // same sizes: distinct shapes are ordered by their signature
+  const QVector<Coord> s = getSignature();
+  const QVector<Coord> sp = piece.getSignature();
+  return std::lexicographical_compare(s.begin(), s.end(), sp.begin(), sp.end());
 }
 
 bool Piece::zLessThan(const Piece & p1, const Piece & p2) {
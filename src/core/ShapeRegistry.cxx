@@ -0,0 +1,117 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+
+#include <algorithm>
+#include "core/ShapeRegistry.hxx"
+
+ShapeRegistry::ShapeRegistry() {
+}
+
+/** sorted local voxels of a piece */
+static QVector<Coord> getLocalVoxels(const Piece & piece) {
+  QVector<Coord> result;
+  for(unsigned int i = 0; i != piece.nbVoxels(); ++i)
+    result.push_back(piece.getLocalCoordById(i));
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+int ShapeRegistry::getId(const Piece & piece) const {
+  QMap<QVector<Coord>, unsigned int>::const_iterator id = ids.find(getLocalVoxels(piece));
+  if (id == ids.end())
+    return -1;
+  return *id;
+}
+
+unsigned int ShapeRegistry::add(const Piece & piece) {
+  const QVector<Coord> key = getLocalVoxels(piece);
+  QMap<QVector<Coord>, unsigned int>::const_iterator id = ids.find(key);
+  if (id != ids.end())
+    return *id;
+
+  const unsigned int shape = sizes.size();
+  const unsigned int nb = piece.nbVoxels();
+  QSharedPointer<Piece> p(piece.clone());
+  (*p).resetTransform();
+
+  QVector<Coord> local;
+  for(unsigned int i = 0; i != nb; ++i)
+    local.push_back((*p).getLocalCoordById(i));
+
+  firsts.push_back(offsets.size());
+  for(Orientation::Type o = 0; o != Orientation::nbOrientations; ++o) {
+    QVector<Coord> voxels(local);
+    Coord::transform(voxels.data(), nb, Orientation::getAngle(o), Orientation::getDirection(o));
+    offsets += voxels;
+    boxes.push_back(Box(voxels));
+    outlines.push_back(Outline());
+  }
+  sizes.push_back(nb);
+  pieces.push_back(p);
+  ids.insert(key, shape);
+
+  return shape;
+}
+
+QVector<Coord> ShapeRegistry::getVoxels(const Placement & p) const {
+  const unsigned int nb = sizes[p.getShape()];
+  const Coord * voxels = getVoxels(p.getShape(), p.getOrientation());
+  const Coord location = p.getLocation();
+  QVector<Coord> result;
+  result.reserve(nb);
+  for(unsigned int i = 0; i != nb; ++i)
+    result.push_back(voxels[i] + location);
+  return result;
+}
+
+const ShapeRegistry::Outline & ShapeRegistry::getOutline(unsigned int shape, Orientation::Type o) const {
+  Outline & outline = outlines[shape * Orientation::nbOrientations + o];
+  if (!outline.computed) {
+    QSharedPointer<Piece> p(createPiece(Placement(shape, o)));
+    outline.faces = (*p).getFacesAndEdges(outline.edges, outline.allEdges);
+    outline.computed = true;
+  }
+  return outline;
+}
+
+QPair<QList<Face>, QList<Edge> > ShapeRegistry::getFacesAndEdges(const Placement & p,
+								  bool removeFlatEdges) const {
+  const Outline & outline = getOutline(p.getShape(), p.getOrientation());
+  const QList<Edge> & edges = removeFlatEdges ? outline.edges : outline.allEdges;
+  const Coord location = p.getLocation();
+  QPair<QList<Face>, QList<Edge> > result;
+  for(QList<Face>::const_iterator f = outline.faces.begin(); f != outline.faces.end(); ++f)
+    result.first.push_back(Face((*f).getLocation() + location, (*f).getDirection()));
+  for(QList<Edge>::const_iterator e = edges.begin(); e != edges.end(); ++e)
+    result.second.push_back(Edge((*e).getLocation() + location, (*e).getDirection()));
+  return result;
+}
+
+Piece * ShapeRegistry::createPiece(const Placement & p) const {
+  Piece * result = (*pieces[p.getShape()]).clone();
+  (*result).transform(Orientation::getAngle(p.getOrientation()),
+		      Orientation::getDirection(p.getOrientation()),
+		      p.getLocation());
+  return result;
+}
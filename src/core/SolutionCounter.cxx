@@ -0,0 +1,150 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+
+#include "core/SolutionCounter.hxx"
+
+SolutionCounter::SolutionCounter(const Solver & s) : solver(s), limit(0), stable(false), nbBoards(0) {
+  solver.setMemoization(true);
+  computeSymmetries();
+  solver.setSymmetries(symmetries);
+}
+
+SolutionCounter::SolutionCounter(const Board & board) : solver(board), limit(0), stable(false), nbBoards(0) {
+  solver.setMemoization(true);
+  computeSymmetries();
+  solver.setSymmetries(symmetries);
+}
+
+void SolutionCounter::computeSymmetries() {
+  const int sx = solver.getSizeX();
+  const int sy = solver.getSizeY();
+  const int sz = solver.getSizeZ();
+  const Box box(sx, sy, sz);
+  const Coord & w1 = solver.getWindow1();
+  const Coord & w2 = solver.getWindow2();
+
+  QVector<bool> inPath(box.volume(), false);
+  for(QVector<Coord>::const_iterator p = solver.getPath().begin(); p != solver.getPath().end(); ++p)
+    if (box.contains(*p))
+      inPath[getIndex(*p)] = true;
+
+  symmetries.clear();
+  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+    Angle::Type a = Angle::A0;
+    do {
+      // the image of the box has to be the box
+      const Coord c1 = Coord(0, 0, 0).getTransform(a, d);
+      const Coord c2 = Coord(sx - 1, sy - 1, sz - 1).getTransform(a, d);
+      const Coord corner(qMin(c1.getX(), c2.getX()), qMin(c1.getY(), c2.getY()), qMin(c1.getZ(), c2.getZ()));
+      const Coord t(-corner.getX(), -corner.getY(), -corner.getZ());
+      bool valid = (qAbs(c2.getX() - c1.getX()) == sx - 1) &&
+	(qAbs(c2.getY() - c1.getY()) == sy - 1) &&
+	(qAbs(c2.getZ() - c1.getZ()) == sz - 1);
+
+      // the windows are preserved (possibly swapped)
+      if (valid) {
+	const Coord i1 = w1.getTransform(a, d, t);
+	const Coord i2 = w2.getTransform(a, d, t);
+	valid = ((i1 == w1) && (i2 == w2)) || ((i1 == w2) && (i2 == w1));
+      }
+
+      // the path is preserved
+      QVector<unsigned int> image;
+      for(Box::const_iterator c = box.begin(); valid && (c != box.end()); ++c) {
+	const unsigned int i = getIndex((*c).getTransform(a, d, t));
+	valid = inPath[getIndex(*c)] == inPath[i];
+	image.push_back(i);
+      }
+
+      if (valid && !symmetries.contains(image))
+	symmetries.push_back(image);
+      ++a;
+    } while(a != Angle::A0);
+  }
+}
+
+QVector<unsigned int> SolutionCounter::getCanonical(const Board & board) const {
+  const unsigned int volume = solver.getSizeX() * solver.getSizeY() * solver.getSizeZ();
+
+  // label of each voxel: the (index + 1) of the piece, 0 if free
+  QVector<unsigned int> labels(volume, 0);
+  unsigned int id = 1;
+  for(Board::const_iterator p = board.begin(); p != board.end(); ++p, ++id)
+    for(Piece::const_iterator c = (*p).begin(); c != (*p).end(); ++c)
+      labels[getIndex(*c)] = id;
+
+  QVector<unsigned int> result;
+  for(QVector<QVector<unsigned int> >::const_iterator s = symmetries.begin(); s != symmetries.end(); ++s) {
+    QVector<unsigned int> image(volume, 0);
+    for(unsigned int v = 0; v != volume; ++v)
+      image[(*s)[v]] = labels[v];
+
+    // the pieces are numbered by order of appearance
+    QVector<unsigned int> names(id, 0);
+    unsigned int next = 1;
+    for(QVector<unsigned int>::iterator v = image.begin(); v != image.end(); ++v)
+      if (*v != 0) {
+	if (names[*v] == 0)
+	  names[*v] = next++;
+	*v = names[*v];
+      }
+
+    if (result.isEmpty() || (image < result))
+      result = image;
+  }
+
+  return result;
+}
+
+bool SolutionCounter::onSolution(const Board & board) {
+  ++nbBoards;
+
+  const bool valid = stable ? board.isStableAndValid() : board.isStaticAndValid();
+  if (!valid || !board.hasPathBetweenWindows())
+    return true;
+
+  const QVector<unsigned int> canonical = getCanonical(board);
+  if (canonicals.contains(canonical))
+    return true;
+  canonicals.insert(canonical);
+  solutions.push_back(board);
+
+  return (limit == 0) || ((unsigned int)solutions.size() < limit);
+}
+
+unsigned int SolutionCounter::count() {
+  canonicals.clear();
+  solutions.clear();
+  nbBoards = 0;
+  solver.solve(*this);
+  return solutions.size();
+}
+
+bool SolutionCounter::hasUniqueSolution() {
+  const unsigned int l = limit;
+  limit = 2;
+  const bool result = count() == 1;
+  limit = l;
+  return result;
+}
@@ -0,0 +1,260 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#include <algorithm>
+#include "core/Solver.hxx"
+#include "core/ExactCover.hxx"
+#include "core/ShapeRegistry.hxx"
+
+/** a listener building the boards from the rows of the exact cover solutions */
+class SolverBoardBuilder : public ExactCover::Listener {
+private:
+  const Board & empty;
+  const ShapeRegistry & shapes;
+  const QVector<ShapeRegistry::Placement> & placements;
+  Solver::Listener & listener;
+public:
+  SolverBoardBuilder(const Board & e,
+		     const ShapeRegistry & s,
+		     const QVector<ShapeRegistry::Placement> & p,
+		     Solver::Listener & l) : empty(e), shapes(s), placements(p), listener(l) {
+  }
+
+  bool onSolution(const QVector<unsigned int> & rows) {
+    Board board(empty);
+    for(QVector<unsigned int>::const_iterator r = rows.begin(); r != rows.end(); ++r) {
+      QSharedPointer<Piece> piece(shapes.createPiece(placements[*r]));
+      board.addPiece(*piece);
+    }
+    return listener.onSolution(board);
+  }
+};
+
+/** a listener keeping the first board */
+class SolverFirstBoard : public Solver::Listener {
+private:
+  Board & board;
+public:
+  SolverFirstBoard(Board & b) : board(b) {
+  }
+
+  bool onSolution(const Board & b) {
+    board = b;
+    return false;
+  }
+};
+
+
+Solver::Solver(unsigned int x, unsigned int y, unsigned int z,
+	       const Coord & w1, const Coord & w2,
+	       const QVector<Coord> & p) : sizeX(x), sizeY(y), sizeZ(z),
+					   window1(w1), window2(w2), path(p),
+					   memoization(false) {
+  path.push_back(w1);
+  path.push_back(w2);
+}
+
+Solver::Solver(const Board & board) : sizeX(board.getSizeX()), sizeY(board.getSizeY()), sizeZ(board.getSizeZ()),
+				      window1(board.getWindowFace1().getLocation()),
+				      window2(board.getWindowFace2().getLocation()),
+				      memoization(false) {
+  const Box & box = board.getBox();
+  for(Box::const_iterator c = box.begin(); c != box.end(); ++c)
+    if (board.getNbPieces(*c) == 0)
+      path.push_back(*c);
+  path.push_back(window1);
+  path.push_back(window2);
+
+  for(Board::const_iterator p = board.begin(); p != board.end(); ++p)
+    addPiece(*p);
+}
+
+QVector<Solver::PieceOrientation> Solver::getOrientations(const Piece & piece) {
+  ShapeRegistry shapes;
+  return getOrientations(shapes, shapes.add(piece));
+}
+
+QVector<Solver::PieceOrientation> Solver::getOrientations(const ShapeRegistry & shapes, unsigned int shape) {
+  QVector<PieceOrientation> result;
+  const unsigned int nb = shapes.getNbVoxels(shape);
+
+  for(Orientation::Type i = 0; i != Orientation::nbOrientations; ++i) {
+    PieceOrientation o;
+    o.direction = Orientation::getDirection(i);
+    o.angle = Orientation::getAngle(i);
+    o.corner = shapes.getBoundedBox(shape, i).getCorner1();
+    const Coord t(-o.corner.getX(), -o.corner.getY(), -o.corner.getZ());
+    const Coord * voxels = shapes.getVoxels(shape, i);
+    for(unsigned int v = 0; v != nb; ++v)
+      o.voxels.push_back(voxels[v] + t);
+    std::sort(o.voxels.begin(), o.voxels.end());
+
+    bool found = false;
+    for(QVector<PieceOrientation>::const_iterator other = result.begin(); other != result.end(); ++other)
+      if ((*other).voxels == o.voxels) {
+	found = true;
+	break;
+      }
+    if (!found)
+      result.push_back(o);
+  }
+
+  return result;
+}
+
+bool Solver::isRepresentative(const QVector<unsigned int> & voxels, int shape, int restrictedShape,
+			      int restrictedVoxel) const {
+  if ((shape != restrictedShape) &&
+      ((restrictedVoxel < 0) || !std::binary_search(voxels.begin(), voxels.end(), (unsigned int)restrictedVoxel)))
+    return true;
+
+  QVector<unsigned int> image(voxels.size());
+  for(QVector<QVector<unsigned int> >::const_iterator s = symmetries.begin(); s != symmetries.end(); ++s) {
+    // only the symmetries fixing the restricted voxel are used
+    if ((shape != restrictedShape) && ((*s)[restrictedVoxel] != (unsigned int)restrictedVoxel))
+      continue;
+    for(int v = 0; v != voxels.size(); ++v)
+      image[v] = (*s)[voxels[v]];
+    std::sort(image.begin(), image.end());
+    if (image < voxels)
+      return false;
+  }
+  return true;
+}
+
+Solver & Solver::addPiece(const Piece & piece, unsigned int count) {
+  const QVector<PieceOrientation> orientations = getOrientations(piece);
+  const QVector<Coord> & voxels = orientations.front().voxels;
+
+  // look for a similar shape
+  for(QVector<QPair<QSharedPointer<Piece>, unsigned int> >::iterator s = inventory.begin();
+      s != inventory.end(); ++s)
+    if ((*(*s).first).nbVoxels() == piece.nbVoxels()) {
+      const QVector<PieceOrientation> others = getOrientations(*(*s).first);
+      for(QVector<PieceOrientation>::const_iterator o = others.begin(); o != others.end(); ++o)
+	if ((*o).voxels == voxels) {
+	  (*s).second += count;
+	  return *this;
+	}
+    }
+
+  inventory.push_back(qMakePair(QSharedPointer<Piece>(piece.clone()), count));
+  return *this;
+}
+
+unsigned int Solver::solve(Listener & listener) const {
+  const Board empty(sizeX, sizeY, sizeZ, window1, window2);
+  const Box & box = empty.getBox();
+
+  // a column for each voxel to cover
+  QVector<int> columns(box.volume(), 0);
+  for(QVector<Coord>::const_iterator p = path.begin(); p != path.end(); ++p)
+    if (box.contains(*p))
+      columns[getIndex(*p)] = -1;
+  unsigned int nbColumns = 0;
+  for(QVector<int>::iterator c = columns.begin(); c != columns.end(); ++c)
+    if (*c == 0)
+      *c = nbColumns++;
+
+  // not enough voxels in the pieces
+  unsigned int volume = 0;
+  for(QVector<QPair<QSharedPointer<Piece>, unsigned int> >::const_iterator s = inventory.begin();
+      s != inventory.end(); ++s)
+    volume += (*(*s).first).nbVoxels() * (*s).second;
+  if (volume < nbColumns)
+    return 0;
+
+  // symmetry breaking: the piece available once with the largest number
+  // of orientations, or else the voxel fixed by the largest number of symmetries
+  int restrictedShape = -1;
+  int restrictedVoxel = -1;
+  if (symmetries.size() > 1) {
+    int nbOrientations = 0;
+    for(int s = 0; s != inventory.size(); ++s)
+      if (inventory[s].second == 1) {
+	const int nb = getOrientations(*inventory[s].first).size();
+	if (nb > nbOrientations) {
+	  restrictedShape = s;
+	  nbOrientations = nb;
+	}
+      }
+    if (restrictedShape < 0) {
+      int nbFixed = 1;
+      for(int v = 0; v != columns.size(); ++v)
+	if (columns[v] >= 0) {
+	  int nb = 0;
+	  for(QVector<QVector<unsigned int> >::const_iterator sym = symmetries.begin(); sym != symmetries.end(); ++sym)
+	    if ((*sym)[v] == (unsigned int)v)
+	      ++nb;
+	  if (nb > nbFixed) {
+	    restrictedVoxel = v;
+	    nbFixed = nb;
+	  }
+	}
+    }
+  }
+
+  // a row for each placement
+  ExactCover problem(nbColumns);
+  problem.setMemoization(memoization);
+  ShapeRegistry shapes;
+  QVector<ShapeRegistry::Placement> placements;
+  for(int s = 0; s != inventory.size(); ++s) {
+    const unsigned int group = problem.addGroup(inventory[s].second);
+    const unsigned int shape = shapes.add(*inventory[s].first);
+    const QVector<PieceOrientation> orientations = getOrientations(shapes, shape);
+    for(QVector<PieceOrientation>::const_iterator o = orientations.begin(); o != orientations.end(); ++o)
+      for(unsigned int z = 0; z != sizeZ; ++z)
+	for(unsigned int y = 0; y != sizeY; ++y)
+	  for(unsigned int x = 0; x != sizeX; ++x) {
+	    QVector<unsigned int> row;
+	    QVector<unsigned int> voxels;
+	    for(QVector<Coord>::const_iterator v = (*o).voxels.begin(); v != (*o).voxels.end(); ++v) {
+	      const Coord c = *v + Coord(x, y, z);
+	      if (!box.contains(c))
+		break;
+	      const int column = columns[getIndex(c)];
+	      if (column < 0)
+		break;
+	      row.push_back(column);
+	      voxels.push_back(getIndex(c));
+	    }
+	    if (row.size() != (*o).voxels.size())
+	      continue;
+	    std::sort(voxels.begin(), voxels.end());
+	    if (!isRepresentative(voxels, s, restrictedShape, restrictedVoxel))
+	      continue;
+	    problem.addRow(row, group);
+	    const Coord location(x - (*o).corner.getX(), y - (*o).corner.getY(), z - (*o).corner.getZ());
+	    placements.push_back(ShapeRegistry::Placement(shape, Orientation::get((*o).direction, (*o).angle), location));
+	  }
+  }
+
+  SolverBoardBuilder builder(empty, shapes, placements, listener);
+  return problem.search(builder);
+}
+
+bool Solver::solve(Board & board) const {
+  SolverFirstBoard first(board);
+  return solve(first) != 0;
+}
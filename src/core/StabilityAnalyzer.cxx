@@ -0,0 +1,188 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+#include "core/StabilityAnalyzer.hxx"
+#include "core/Board.hxx"
+#include <QPair>
+#include <algorithm>
+
+StabilityAnalyzer::StabilityAnalyzer(const Board & board) : nbPieces(board.getNbPieces()),
+							    indices(board.getNbSlots(), 0) {
+  unsigned int i = 0;
+  for(Board::const_iterator p = board.begin(); p != board.end(); ++p, ++i)
+    indices[p.getSlot()] = i;
+
+  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+    buildGraph(board, d);
+    computeGroups(d);
+  }
+}
+
+void StabilityAnalyzer::buildGraph(const Board & board, Direction::Type d) {
+  const unsigned int wall = nbPieces;
+  QVector<QPair<unsigned int, unsigned int> > arcs;
+
+  unsigned int index = 0;
+  for(Board::const_iterator p = board.begin(); p != board.end(); ++p, ++index) {
+    const quint32 slot = p.getSlot();
+    const Coord * v = board.getOffsets(slot);
+    const Coord t = board.locations[slot] + d;
+    for(unsigned int k = 0; k != board.getNbVoxels(slot); ++k) {
+      const Coord n = v[k] + t;
+      if (!board.box.contains(n)) {
+	if (!board.allowOutside)
+	  arcs.push_back(qMakePair(index, wall));
+      }
+      else {
+	const quint32 cell = board.cells[board.getCellOffset(n)];
+	if (cell == Board::overlapCell) {
+	  const QVector<quint32> ids = board.getCellIds(board.getCellOffset(n));
+	  for(QVector<quint32>::const_iterator id = ids.begin(); id != ids.end(); ++id)
+	    if (*id != slot + 1)
+	      arcs.push_back(qMakePair(index, indices[*id - 1]));
+	}
+	else if ((cell != 0) && (cell != slot + 1))
+	  arcs.push_back(qMakePair(index, indices[cell - 1]));
+      }
+    }
+  }
+
+  // compressed rows (counting sort on the source)
+  QVector<unsigned int> & f = first[d];
+  QVector<unsigned int> & t = targets[d];
+  f.fill(0, nbPieces + 2);
+  for(QVector<QPair<unsigned int, unsigned int> >::const_iterator a = arcs.begin(); a != arcs.end(); ++a)
+    ++f[(*a).first + 1];
+  for(unsigned int i = 0; i != nbPieces + 1; ++i)
+    f[i + 1] += f[i];
+  t.resize(arcs.size());
+  QVector<unsigned int> pos(f);
+  for(QVector<QPair<unsigned int, unsigned int> >::const_iterator a = arcs.begin(); a != arcs.end(); ++a)
+    t[pos[(*a).first]++] = (*a).second;
+}
+
+void StabilityAnalyzer::computeGroups(Direction::Type d) {
+  const QVector<unsigned int> & f = first[d];
+  const QVector<unsigned int> & t = targets[d];
+  const unsigned int nbNodes = nbPieces + 1;
+  const unsigned int undefined = nbNodes;
+
+  // iterative version of Tarjan's algorithm
+  QVector<unsigned int> index(nbNodes, undefined);
+  QVector<unsigned int> lowlink(nbNodes, 0);
+  QVector<unsigned int> component(nbNodes, undefined);
+  QVector<unsigned int> stack;
+  QVector<QPair<unsigned int, unsigned int> > calls;
+  unsigned int nbVisited = 0;
+  unsigned int nbComponents = 0;
+
+  for(unsigned int root = 0; root != nbNodes; ++root) {
+    if (index[root] != undefined)
+      continue;
+    calls.push_back(qMakePair(root, f[root]));
+    index[root] = lowlink[root] = nbVisited++;
+    stack.push_back(root);
+
+    while(!calls.isEmpty()) {
+      const unsigned int v = calls.back().first;
+      unsigned int & next = calls.back().second;
+      if (next != f[v + 1]) {
+	const unsigned int w = t[next++];
+	if (index[w] == undefined) {
+	  index[w] = lowlink[w] = nbVisited++;
+	  stack.push_back(w);
+	  calls.push_back(qMakePair(w, f[w]));
+	}
+	else if (component[w] == undefined)
+	  lowlink[v] = qMin(lowlink[v], index[w]);
+      }
+      else {
+	calls.pop_back();
+	if (!calls.isEmpty()) {
+	  const unsigned int u = calls.back().first;
+	  lowlink[u] = qMin(lowlink[u], lowlink[v]);
+	}
+	if (lowlink[v] == index[v]) {
+	  unsigned int w;
+	  do {
+	    w = stack.back();
+	    stack.pop_back();
+	    component[w] = nbComponents;
+	  } while(w != v);
+	  ++nbComponents;
+	}
+      }
+    }
+  }
+
+  // a component with an arc to another component is not a sink
+  QVector<bool> sink(nbComponents, true);
+  for(unsigned int v = 0; v != nbNodes; ++v)
+    for(unsigned int a = f[v]; a != f[v + 1]; ++a)
+      if (component[t[a]] != component[v])
+	sink[component[v]] = false;
+  sink[component[nbPieces]] = false;
+
+  QVector<int> group(nbComponents, -1);
+  groups[d].clear();
+  for(unsigned int v = 0; v != nbPieces; ++v)
+    if (sink[component[v]]) {
+      if (group[component[v]] < 0) {
+	group[component[v]] = groups[d].size();
+	groups[d].push_back(QVector<unsigned int>());
+      }
+      groups[d][group[component[v]]].push_back(v);
+    }
+}
+
+QVector<unsigned int> StabilityAnalyzer::getMovableClosure(unsigned int piece, Direction::Type d) const {
+  Q_ASSERT(piece < nbPieces);
+  Q_ASSERT(d != Direction::Static);
+  const QVector<unsigned int> & f = first[d];
+  const QVector<unsigned int> & t = targets[d];
+
+  QVector<bool> seen(nbPieces + 1, false);
+  QVector<unsigned int> result;
+  result.push_back(piece);
+  seen[piece] = true;
+  for(int i = 0; i != result.size(); ++i) {
+    const unsigned int v = result[i];
+    for(unsigned int a = f[v]; a != f[v + 1]; ++a)
+      if (!seen[t[a]]) {
+	if (t[a] == nbPieces)
+	  return QVector<unsigned int>();
+	seen[t[a]] = true;
+	result.push_back(t[a]);
+      }
+  }
+
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+bool StabilityAnalyzer::isStable() const {
+  for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d)
+    if (!groups[d].isEmpty())
+      return false;
+  return true;
+}
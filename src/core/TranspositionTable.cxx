@@ -0,0 +1,88 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+
+
+#include "core/TranspositionTable.hxx"
+
+const unsigned int TranspositionTable::bucketSize;
+const unsigned int TranspositionTable::maxDepth;
+const quint64 TranspositionTable::validData;
+
+TranspositionTable::TranspositionTable(unsigned int log2Buckets) : entries(bucketSize << log2Buckets),
+								   mask(((quint64)1 << log2Buckets) - 1) {
+  Q_ASSERT(log2Buckets < 32);
+  table = entries.data();
+}
+
+bool TranspositionTable::insert(quint64 key, quint32 value, unsigned int depth) {
+  const quint64 data = getData(value, depth);
+  Entry * bucket = table + (key & mask) * bucketSize;
+
+  // the entry of the key, the first empty entry, or the entry with the smallest depth
+  unsigned int victim = 0;
+  unsigned int victimDepth = maxDepth + 1;
+  bool empty = false;
+  for(unsigned int i = 0; i != bucketSize; ++i) {
+    quint64 current;
+    if (read(bucket[i], key, current)) {
+      write(bucket[i], key, data);
+      return false;
+    }
+    if ((current & validData) == 0) {
+      if (!empty) {
+	victim = i;
+	empty = true;
+      }
+    }
+    else if (!empty && (getDepth(current) < victimDepth)) {
+      victim = i;
+      victimDepth = getDepth(current);
+    }
+  }
+
+  // an entry written by another thread in the meantime is overwritten
+  write(bucket[victim], key, data);
+  return true;
+}
+
+bool TranspositionTable::find(quint64 key, quint32 & value, unsigned int & depth) const {
+  const Entry * bucket = table + (key & mask) * bucketSize;
+
+  for(unsigned int i = 0; i != bucketSize; ++i) {
+    quint64 data;
+    if (read(bucket[i], key, data)) {
+      value = data & 0xFFFFFFFF;
+      depth = getDepth(data);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void TranspositionTable::clear() {
+  for(int i = 0; i != entries.size(); ++i) {
+    table[i].key.storeRelaxed(0);
+    table[i].data.storeRelaxed(0);
+  }
+}
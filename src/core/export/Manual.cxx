@@ -590,7 +590,7 @@ void Manual::drawBoard(QGraphicsScene & scene,
   // create drawing objects
   QVector<DObject> objects;
   for(QVector<QSharedPointer<Piece> >::const_iterator p = oldpieces.begin(); p != oldpieces.end(); ++p) {
-    QPair<QList<Face>, QList<Edge> > fae = (**p).getFacesAndEdges(true);
+    QPair<QList<Face>, QList<Edge> > fae = shapes.getFacesAndEdges(shapes.getPlacement(**p), true);
     for(QList<Face>::const_iterator f = fae.first.begin(); f != fae.first.end(); ++f)
       objects.push_back(DObject(QSharedPointer<Face>(new Face(*f)), false));
     for(QList<Edge>::const_iterator e = fae.second.begin(); e != fae.second.end(); ++e)
@@ -599,7 +599,7 @@ void Manual::drawBoard(QGraphicsScene & scene,
 
   if (drawNewPieces)
     for(QVector<QSharedPointer<Piece> >::const_iterator p = newpieces.begin(); p != newpieces.end(); ++p) {
-      QPair<QList<Face>, QList<Edge> > fae = (**p).getFacesAndEdges(true);
+      QPair<QList<Face>, QList<Edge> > fae = shapes.getFacesAndEdges(shapes.getPlacement(**p), true);
       for(QList<Face>::const_iterator f = fae.first.begin(); f != fae.first.end(); ++f)
 	objects.push_back(DObject(QSharedPointer<Face>(new Face(*f)), true));
       for(QList<Edge>::const_iterator e = fae.second.begin(); e != fae.second.end(); ++e)
@@ -657,7 +657,7 @@ void Manual::drawCaption(QGraphicsScene & scene,
     QFont font("DejaVu Sans", layout.getFontSize());
     unsigned int idCaption = 0;
     for (QMap<AbstractPiece, unsigned int>::const_iterator piece = pgroup.begin(); piece != pgroup.end(); ++piece, ++idCaption) {
-      QPair<QList<Face>, QList<Edge> > fae = (*(piece.key())).getFacesAndEdges(false);
+      QPair<QList<Face>, QList<Edge> > fae = shapes.getFacesAndEdges(shapes.getPlacement(*(piece.key())), false);
       QVector<DObject> objects;
       for(QList<Face>::const_iterator f = fae.first.begin(); f != fae.first.end(); ++f)
 	objects.push_back(DObject(QSharedPointer<Face>(new Face(*f)), true));
@@ -29,6 +29,8 @@
 #include "core/StraightPiece.hxx"
 #include "core/LPiece.hxx"
 #include "core/GenericPiece.hxx"
+#include "core/StabilityAnalyzer.hxx"
+#include "core/ChunkedArray.hxx"
 
 
 class testBoard : public QObject {
@@ -78,6 +80,147 @@ private slots:
   }
 
 
+  void testIntersections(void) {
+    int x = 5;
+    Board board(x, x, x, Coord(0, 0, 0), Coord(x - 1, x - 1, x - 1),
+		Direction::Static, Direction::Static, true);
+    StraightPiece p1(4, Coord(0, 0, 0), Direction::Xplus);
+    StraightPiece p2(4, Coord(1, 0, 0), Direction::Yplus);
+    StraightPiece p3(4, Coord(0, 0, 0), Direction::Zplus);
+    StraightPiece p4(3, Coord(1, 1, 0), Direction::Xplus);
+    board.addPiece(p1);
+    board.addPiece(p2);
+    board.addPiece(p3);
+    board.addPiece(p4);
+    QVERIFY(board.getNbPieces(Coord(0, 0, 0)) == 2);
+    QVERIFY(board.getNbPieces(Coord(1, 0, 0)) == 2);
+    QVERIFY(board.getNbPieces(Coord(1, 1, 0)) == 2);
+    QVERIFY(board.getNbPieces(Coord(3, 0, 0)) == 1);
+    QVERIFY(!board.isValid());
+    QVERIFY(board.checkInternalMemoryState());
+
+    // remove the first piece: the other ones are shifted
+    board.removePiece(board.begin());
+    QVERIFY(board.getNbPieces(Coord(0, 0, 0)) == 1);
+    QVERIFY(board.getNbPieces(Coord(1, 0, 0)) == 1);
+    QVERIFY(board.getNbPieces(Coord(3, 0, 0)) == 0);
+    QVERIFY(board.getPieces(1, 1, 0).size() == 2);
+    QVERIFY(board.checkInternalMemoryState());
+
+    board.removePiece(board.begin());
+    QVERIFY(board.isValid());
+    QVERIFY(board.getNbPieces(Coord(1, 1, 0)) == 1);
+    QVERIFY(*(board.getPieces(1, 1, 0).front()) == p4);
+    QVERIFY(board.checkInternalMemoryState());
+
+    Board board2(board);
+    QVERIFY(board == board2);
+    QVERIFY(board2.checkInternalMemoryState());
+  }
+
+  void testLargeBoard(void) {
+    // pieces across the 64-bit words of the rows
+    Board board(130, 3, 3, Coord(0, 1, 1), Coord(129, 1, 1));
+    board.addPiece(StraightPiece(60, Coord(0, 1, 1), Direction::Xplus));
+    board.addPiece(StraightPiece(10, Coord(60, 1, 1), Direction::Xplus));
+    board.addPiece(StraightPiece(60, Coord(70, 1, 1), Direction::Xplus));
+    board.addPattern(Pattern::parallelepiped(130, 1, 3, Coord(0, 0, 0)));
+    board.addPattern(Pattern::parallelepiped(130, 1, 3, Coord(0, 2, 0)));
+    for(unsigned int x = 0; x != 130; ++x) {
+      board.addPiece(StraightPiece(1, Coord(x, 1, 0)));
+      board.addPiece(StraightPiece(1, Coord(x, 1, 2)));
+    }
+    QVERIFY(board.isValid());
+    QVERIFY(board.isStaticAndValid());
+    QVERIFY(board.checkInternalMemoryState());
+
+    Board::iterator second = board.begin();
+    ++second;
+    QVERIFY(!board.isMovablePiece(second));
+    board.removePiece(board.begin());
+    Board::iterator middle = board.begin();
+    QVERIFY(board.isMovablePiece(middle));
+    board.movePiece(middle, Direction::Xminus);
+    QVERIFY(board.isMovablePiece(middle));
+    bool blocked = false;
+    try {
+      board.movePiece(middle, Direction::Yplus);
+    }
+    catch (ExceptionIntersection &) {
+      blocked = true;
+    }
+    QVERIFY(blocked);
+    QVERIFY(board.checkInternalMemoryState());
+  }
+
+  void testLongPath(void) {
+    // the path goes along the whole board, across the words of the rows
+    Board board(70, 3, 1, Coord(0, 0, 0), Coord(0, 2, 0));
+    board.addPiece(StraightPiece(69, Coord(0, 1, 0), Direction::Xplus));
+    QVERIFY(board.hasPathBetweenWindows());
+    board.addPiece(StraightPiece(1, Coord(69, 1, 0), Direction::Xplus));
+    QVERIFY(!board.hasPathBetweenWindows());
+    board.removePiece(board.begin());
+    QVERIFY(board.hasPathBetweenWindows());
+    board.addPiece(StraightPiece(1, Coord(0, 2, 0), Direction::Xplus));
+    QVERIFY(!board.hasPathBetweenWindows());
+  }
+
+  void testFreeSpace(void) {
+    Board board(70, 3, 2, Coord(0, 0, 0), Coord(0, 2, 0));
+    board.addPattern(Pattern::parallelepiped(70, 1, 2, Coord(0, 1, 0)));
+    board.addPiece(StraightPiece(1, Coord(69, 2, 1), Direction::Xplus));
+    board.addPiece(StraightPiece(1, Coord(68, 2, 0), Direction::Xplus));
+    FreeSpace space = board.getFreeSpace();
+    QVERIFY(space.getNbComponents() == 3);
+    QVERIFY(space.getLabel(Coord(0, 1, 0)) == FreeSpace::noComponent);
+    QVERIFY(space.areConnected(Coord(0, 0, 0), Coord(69, 0, 1)));
+    QVERIFY(!space.areConnected(Coord(0, 0, 0), Coord(0, 1, 1)));
+    QVERIFY(!space.areConnected(Coord(0, 0, 0), Coord(0, 2, 0)));
+    QVERIFY(!space.areConnected(Coord(0, 2, 1), Coord(69, 2, 0)));
+    QVERIFY(space.areConnected(Coord(0, 2, 1), Coord(68, 2, 1)));
+    QVERIFY(!board.hasPathBetweenWindows());
+
+    // same number of components, but not the same partition
+    BitBoard u1(Box(4, 1, 1));
+    u1.set(Coord(1, 0, 0));
+    BitBoard u2(Box(4, 1, 1));
+    u2.set(Coord(2, 0, 0));
+    FreeSpace s1(u1);
+    FreeSpace s2(u2);
+    QVERIFY(s1.getNbComponents() == s2.getNbComponents());
+    QVERIFY(!s1.hasSameComponents(s2));
+    s2.release(Coord(2, 0, 0)).use(Coord(1, 0, 0));
+    QVERIFY(s1.hasSameComponents(s2));
+
+    // splits of a component, found by flood fills
+    BitBoard wall(Box(70, 3, 1));
+    for(unsigned int x = 1; x != 69; ++x)
+      wall.set(Coord(x, 1, 0));
+    FreeSpace ring(wall);
+    QVERIFY(ring.getNbComponents() == 1);
+    ring.use(Coord(0, 1, 0));
+    wall.set(Coord(0, 1, 0));
+    QVERIFY(ring.getNbComponents() == 1);
+    QVERIFY(wall.hasFreePath(Coord(0, 0, 0), Coord(0, 2, 0)));
+    ring.use(Coord(69, 1, 0));
+    wall.set(Coord(69, 1, 0));
+    QVERIFY(ring.getNbComponents() == 2);
+    QVERIFY(!ring.areConnected(Coord(0, 0, 0), Coord(0, 2, 0)));
+    QVERIFY(!wall.hasFreePath(Coord(0, 0, 0), Coord(0, 2, 0)));
+    QVERIFY(ring.hasSameComponents(FreeSpace(wall)));
+    QVERIFY(wall.getFreeComponent(Coord(3, 2, 0)).get(Coord(69, 2, 0)));
+    QVERIFY(!wall.getFreeComponent(Coord(3, 2, 0)).get(Coord(69, 0, 0)));
+
+    BitBoard corners(Box(3, 3, 1));
+    corners.set(Coord(0, 0, 0)).set(Coord(2, 0, 0)).set(Coord(0, 2, 0)).set(Coord(2, 2, 0));
+    FreeSpace cross(corners);
+    cross.use(Coord(1, 1, 0));
+    corners.set(Coord(1, 1, 0));
+    QVERIFY(cross.getNbComponents() == 4);
+    QVERIFY(cross.hasSameComponents(FreeSpace(corners)));
+  }
+
   void testMove(void) {
     int x = 10;
     Board board1(x, x, x, Coord(0, 0, 0), Coord(x - 1, x - 1, x - 1));
@@ -93,6 +236,11 @@ private slots:
     QVERIFY(board1 == board2);
     QVERIFY(board1.checkInternalMemoryState());
     QVERIFY(board2.checkInternalMemoryState());
+
+    board1.addPiece(StraightPiece(4, Coord(0, 3, 0), Direction::Xplus));
+    QVERIFY(board1.getMoveStatus(board1.begin(), Direction::Xplus) == MoveStatus::Ok);
+    QVERIFY(board1.getMoveStatus(board1.begin(), Direction::Xminus) == MoveStatus::Outside);
+    QVERIFY(board1.getMoveStatus(board1.begin(), Direction::Yplus) == MoveStatus::Intersection);
   }
 
 
@@ -187,6 +335,371 @@ private slots:
     }
    }
 
+  void testStability(void) {
+    // two interlocked pieces that can only move together
+    Board board(4, 4, 1, Coord(3, 0, 0), Coord(3, 3, 0));
+    QVector<Coord> c1;
+    c1.push_back(Coord(0, 0, 0));
+    c1.push_back(Coord(1, 0, 0));
+    c1.push_back(Coord(1, 1, 0));
+    c1.push_back(Coord(1, 2, 0));
+    QVector<Coord> c2;
+    c2.push_back(Coord(0, 1, 0));
+    c2.push_back(Coord(0, 2, 0));
+    c2.push_back(Coord(0, 3, 0));
+    c2.push_back(Coord(1, 3, 0));
+    c2.push_back(Coord(2, 3, 0));
+    c2.push_back(Coord(2, 2, 0));
+    c2.push_back(Coord(2, 1, 0));
+    c2.push_back(Coord(2, 0, 0));
+    board.addPiece(GenericPiece(c1, Coord(0, 0, 0)));
+    board.addPiece(GenericPiece(c2, Coord(0, 0, 0)));
+    QVERIFY(board.isStaticAndValid());
+    QVERIFY(!board.isStableAndValid());
+
+    {
+      StabilityAnalyzer analyzer(board);
+      QVERIFY(analyzer.getMovableGroups(Direction::Xplus).size() == 1);
+      QVERIFY(analyzer.getMovableGroups(Direction::Xplus).front().size() == 2);
+      QVERIFY(analyzer.getMovableGroups(Direction::Xminus).isEmpty());
+      QVERIFY(analyzer.getMovableGroups(Direction::Yplus).isEmpty());
+      QVERIFY(analyzer.getMovableClosure(0, Direction::Xplus).size() == 2);
+      QVERIFY(analyzer.getMovableClosure(0, Direction::Yminus).isEmpty());
+    }
+
+    board.addPiece(StraightPiece(4, Coord(3, 0, 0), Direction::Yplus));
+    QVERIFY(board.isStableAndValid());
+  }
+
+  void testCanonical(void) {
+    Board board(2, 3, 4, Coord(0, 0, 1), Coord(1, 2, 3), Direction::Xminus, Direction::Zplus);
+    board.addPiece(StraightPiece(3, Coord(1, 0, 0), Direction::Zplus));
+    board.addPiece(LPiece(3, 2, Coord(0, 1, 1), Direction::Zplus, Angle::A0));
+    board.addPiece(StraightPiece(2, Coord(0, 2, 2), Direction::Xplus));
+    const quint64 hash = board.getCanonicalHash();
+
+    // the rotated boards have the same canonical form
+    for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d) {
+      Angle::Type a = Angle::A0;
+      do {
+	const Coord c = Coord(1, 2, 3).getTransform(a, d);
+	const Coord t(c.getX() < 0 ? -c.getX() : 0, c.getY() < 0 ? -c.getY() : 0, c.getZ() < 0 ? -c.getZ() : 0);
+	Direction::Type f1 = Direction::Xplus;
+	Direction::Type f2 = Direction::Xplus;
+	for(Direction::Type f = Direction::Xplus; f != Direction::Static; ++f) {
+	  if ((Coord(0, 0, 0) + f) == (Coord(0, 0, 0) + Direction::Xminus).getTransform(a, d))
+	    f1 = f;
+	  if ((Coord(0, 0, 0) + f) == (Coord(0, 0, 0) + Direction::Zplus).getTransform(a, d))
+	    f2 = f;
+	}
+	Board rotated(qAbs(c.getX()) + 1, qAbs(c.getY()) + 1, qAbs(c.getZ()) + 1,
+		      Coord(0, 0, 1).getTransform(a, d, t), Coord(1, 2, 3).getTransform(a, d, t), f1, f2);
+	for(Board::const_iterator p = board.begin(); p != board.end(); ++p) {
+	  QVector<Coord> coords;
+	  for(Piece::const_iterator v = (*p).begin(); v != (*p).end(); ++v)
+	    coords.push_back((*v).getTransform(a, d, t));
+	  rotated.addPiece(GenericPiece(coords, Coord(0, 0, 0)));
+	}
+	QVERIFY(rotated.isValid());
+	QVERIFY(rotated.getCanonicalForm() == board.getCanonicalForm());
+	QVERIFY(rotated.getCanonicalHash() == hash);
+	++a;
+      } while(a != Angle::A0);
+    }
+
+    Board other(board);
+    other.movePiece(other.begin(), Direction::Yplus);
+    QVERIFY(other.getCanonicalHash() != hash);
+
+    // a chiral board and its mirror image
+    QVector<Coord> coords;
+    coords.push_back(Coord(0, 0, 0));
+    coords.push_back(Coord(1, 0, 0));
+    coords.push_back(Coord(1, 1, 0));
+    coords.push_back(Coord(1, 1, 1));
+    QVector<Coord> mirrored;
+    for(QVector<Coord>::const_iterator c = coords.begin(); c != coords.end(); ++c)
+      mirrored.push_back(Coord(1 - (*c).getX(), (*c).getY(), (*c).getZ()));
+    Board chiral(2, 2, 2, Coord(0, 0, 0), Coord(0, 0, 0), Direction::Yminus, Direction::Yminus);
+    chiral.addPiece(GenericPiece(coords, Coord(0, 0, 0)));
+    Board mirror(2, 2, 2, Coord(1, 0, 0), Coord(1, 0, 0), Direction::Yminus, Direction::Yminus);
+    mirror.addPiece(GenericPiece(mirrored, Coord(0, 0, 0)));
+    QVERIFY(chiral.getCanonicalHash() != mirror.getCanonicalHash());
+    QVERIFY(chiral.getCanonicalHash(true) == mirror.getCanonicalHash(true));
+  }
+
+  void testHash(void) {
+    Board board(6, 6, 6);
+    QVERIFY(board.getHash() == 0);
+    board.addPiece(StraightPiece(3, Coord(0, 0, 0), Direction::Xplus));
+    board.addPiece(LPiece(3, 2, Coord(0, 2, 1), Direction::Zplus, Angle::A0));
+    board.addPiece(StraightPiece(2, Coord(4, 4, 4), Direction::Yplus));
+    const quint64 hash = board.getHash();
+    QVERIFY(hash != 0);
+    QVERIFY(board.checkInternalMemoryState());
+
+    // moves
+    Board::iterator first = board.begin();
+    board.movePiece(first, Direction::Zplus);
+    QVERIFY(board.getHash() != hash);
+    QVERIFY(board.checkInternalMemoryState());
+    Board::iterator moved = board.begin();
+    board.movePiece(moved, Direction::Zminus);
+    QVERIFY(board.getHash() == hash);
+
+    // the order of the pieces is not used
+    Board other(6, 6, 6);
+    other.addPiece(StraightPiece(2, Coord(4, 4, 4), Direction::Yplus));
+    other.addPiece(StraightPiece(3, Coord(2, 0, 0), Direction::Xminus));
+    other.addPiece(LPiece(3, 2, Coord(0, 2, 1), Direction::Zplus, Angle::A0));
+    QVERIFY(other.getHash() == hash);
+    QVERIFY(Board(other).getHash() == hash);
+
+    // the same voxels, split in other pieces
+    Board split(6, 6, 6);
+    split.addPiece(StraightPiece(2, Coord(0, 0, 0), Direction::Xplus));
+    split.addPiece(StraightPiece(1, Coord(2, 0, 0), Direction::Xplus));
+    split.addPiece(LPiece(3, 2, Coord(0, 2, 1), Direction::Zplus, Angle::A0));
+    split.addPiece(StraightPiece(2, Coord(4, 4, 4), Direction::Yplus));
+    QVERIFY(split.getHash() != hash);
+
+    other.removePiece(other.begin());
+    QVERIFY(other.getHash() != hash);
+    QVERIFY(other.checkInternalMemoryState());
+    other.addPiece(StraightPiece(2, Coord(4, 4, 4), Direction::Yplus));
+    QVERIFY(other.getHash() == hash);
+  }
+
+  void testCopy(void) {
+    Board board(6, 6, 6);
+    const StraightPiece straight(3, Coord(0, 0, 0), Direction::Xplus);
+    const LPiece l(3, 2, Coord(0, 2, 1), Direction::Zplus, Angle::A0);
+    board.addPiece(straight);
+    board.addPiece(l);
+    board.addPiece(StraightPiece(2, Coord(4, 4, 4), Direction::Yplus));
+
+    // the copies share the objects of the pieces, replaced by a move
+    Board other(board);
+    QVERIFY(other == board);
+    QVERIFY(other.getPieces()[1] == board.getPieces()[1]);
+    const QSharedPointer<Piece> shared = other.getPieces()[1];
+    Board::iterator second = other.begin();
+    ++second;
+    other.movePiece(second, Direction::Yplus);
+    QVERIFY(other.checkInternalMemoryState());
+    QVERIFY(board.checkInternalMemoryState());
+    QVERIFY(*(board.getPieces()[1]) == l);
+    QVERIFY(board.getPieces()[1] == shared);
+    QVERIFY(*shared == l);
+    QVERIFY(!(*(other.getPieces()[1]) == l));
+    QVERIFY((*(other.getPieces()[1])).getLocation() == Coord(0, 3, 1));
+    QVERIFY((*second).getLocation() == Coord(0, 3, 1));
+    QVERIFY(other.getPieces()[0] == board.getPieces()[0]);
+    QVERIFY(*(other.getPieces()[0]) == *(board.getPieces()[0]));
+    QVERIFY(other.getNbPieces(0, 2, 1) == 0);
+    QVERIFY(board.getNbPieces(0, 2, 1) == 1);
+
+    // the moved piece keeps its type
+    other.movePiece(second, Direction::Yminus);
+    QVERIFY(other == board);
+    QVERIFY(*(other.getPieces()[1]) == l);
+    QVERIFY(other.getHash() == board.getHash());
+
+    other = board;
+    other.removePiece(other.begin());
+    QVERIFY(other.checkInternalMemoryState());
+    QVERIFY(*(other.getPieces()[0]) == l);
+    QVERIFY(board.getNbPieces() == 3);
+  }
+
+  void testHandles(void) {
+    Board board(6, 6, 6);
+    const StraightPiece p1(3, Coord(0, 0, 0), Direction::Xplus);
+    const LPiece p2(3, 2, Coord(0, 2, 1), Direction::Zplus, Angle::A0);
+    const StraightPiece p3(2, Coord(4, 4, 4), Direction::Yplus);
+    board.addPiece(p1);
+    board.addPiece(p2);
+    board.addPiece(p3);
+
+    Board::iterator second = board.begin();
+    ++second;
+    Board::iterator third = second;
+    ++third;
+    const Board::Handle h1 = board.getHandle(board.begin());
+    const Board::Handle h2 = board.getHandle(second);
+    const Board::Handle h3 = board.getHandle(third);
+    QVERIFY((h1 != h2) && (h2 != h3));
+
+    // the references to the other pieces are not shifted by a removal
+    board.removePiece(second);
+    QVERIFY(!board.contains(h2));
+    QVERIFY(!(board.find(h2) != board.end()));
+    QVERIFY(board.contains(h1) && board.contains(h3));
+    QVERIFY(*third == p3);
+    QVERIFY(*(board.find(h3)) == p3);
+    board.movePiece(board.find(h3), Direction::Xplus);
+    QVERIFY((*third).getLocation() == Coord(5, 4, 4));
+    QVERIFY(board.checkInternalMemoryState());
+
+    // the slot is reused, but not the handle
+    const StraightPiece p4(2, Coord(0, 4, 0), Direction::Zplus);
+    board.addPiece(p4);
+    QVERIFY(!board.contains(h2));
+    QVERIFY(board.getNbPieces() == 3);
+    QVERIFY(*(board.getPieces()[1]) == StraightPiece(2, Coord(5, 4, 4), Direction::Yplus));
+    QVERIFY(*(board.getPieces()[2]) == p4);
+    QVERIFY(board.checkInternalMemoryState());
+
+    // the order of the pieces is restored by a rollback
+    board.beginTransaction();
+    board.removePiece(board.begin());
+    board.removePiece(board.find(h3));
+    board.addPiece(p2);
+    Board::iterator added = board.begin();
+    ++added;
+    const Board::Handle hAdded = board.getHandle(added);
+    board.rollbackTransaction();
+    QVERIFY(*(board.getPieces()[0]) == p1);
+    QVERIFY(*(board.getPieces()[2]) == p4);
+    QVERIFY(board.checkInternalMemoryState());
+
+    // and the handles of the restored pieces are valid again
+    QVERIFY(board.contains(h1) && board.contains(h3));
+    QVERIFY(!board.contains(hAdded));
+    board.removePiece(board.find(h3));
+    board.addPiece(p2);
+    QVERIFY(!board.contains(hAdded));
+
+    // many pieces
+    Board large(20, 20, 20);
+    QVector<Board::Handle> handles;
+    for(unsigned int z = 0; z != 20; ++z)
+      for(unsigned int y = 0; y != 20; ++y)
+	for(unsigned int x = 0; x != 20; x += 2)
+	  large.addPiece(StraightPiece(2, Coord(x, y, z), Direction::Xplus));
+    for(Board::const_iterator p = large.begin(); p != large.end(); ++p)
+      handles.push_back(large.getHandle(p));
+    QVERIFY(handles.size() == 4000);
+    for(int i = 0; i < handles.size(); i += 2)
+      large.removePiece(large.find(handles[i]));
+    QVERIFY(large.getNbPieces() == 2000);
+    for(int i = 0; i != handles.size(); ++i)
+      QVERIFY(large.contains(handles[i]) == (i % 2 == 1));
+    QVERIFY((*(large.find(handles[1]))).getLocation() == Coord(2, 0, 0));
+    QVERIFY(large.checkInternalMemoryState());
+  }
+
+  void testTransactions(void) {
+    Board board(6, 6, 6);
+    const LPiece l(3, 2, Coord(0, 2, 1), Direction::Zplus, Angle::A0);
+    board.addPiece(StraightPiece(3, Coord(0, 0, 0), Direction::Xplus));
+    board.addPiece(l);
+    board.addPiece(StraightPiece(2, Coord(4, 4, 4), Direction::Yplus));
+    const Board reference(board);
+
+    // rollback of each kind of modification
+    board.beginTransaction();
+    board.movePiece(board.begin(), Direction::Yplus);
+    Board::iterator second = board.begin();
+    ++second;
+    board.removePiece(second);
+    board.addPiece(StraightPiece(2, Coord(5, 0, 0), Direction::Zplus));
+    QVERIFY(board.getNbTransactions() == 1);
+    QVERIFY(!(board == reference));
+    board.rollbackTransaction();
+    QVERIFY(board.getNbTransactions() == 0);
+    QVERIFY(board == reference);
+    QVERIFY(board.checkInternalMemoryState());
+    QVERIFY(board.getHash() == reference.getHash());
+    QVERIFY(*(board.getPieces()[1]) == l);
+
+    // nested transactions
+    board.beginTransaction();
+    board.movePiece(board.begin(), Direction::Yplus);
+    board.beginTransaction();
+    board.removePiece(board.begin());
+    board.commitTransaction();
+    const Board moved(board);
+    board.beginTransaction();
+    board.movePiece(board.begin(), Direction::Zminus);
+    board.rollbackTransaction();
+    QVERIFY(board == moved);
+    board.rollbackTransaction();
+    QVERIFY(board == reference);
+    QVERIFY(board.checkInternalMemoryState());
+    QVERIFY(!board.canUndo());
+
+    // undo and redo
+    board.setUndoEnabled(true);
+    board.movePiece(board.begin(), Direction::Yplus);
+    const Board step1(board);
+    board.beginTransaction();
+    board.removePiece(board.begin());
+    board.addPiece(StraightPiece(2, Coord(5, 0, 0), Direction::Zplus));
+    board.commitTransaction();
+    const Board step2(board);
+    QVERIFY(board.canUndo() && !board.canRedo());
+    board.undo();
+    QVERIFY(board == step1);
+    board.undo();
+    QVERIFY(board == reference);
+    QVERIFY(board.checkInternalMemoryState());
+    QVERIFY(!board.canUndo() && board.canRedo());
+    board.redo();
+    QVERIFY(board == step1);
+    board.redo();
+    QVERIFY(board == step2);
+    QVERIFY(board.checkInternalMemoryState());
+    board.undo();
+
+    // a rolled back transaction keeps the redo history
+    board.beginTransaction();
+    board.movePiece(board.begin(), Direction::Yminus);
+    board.rollbackTransaction();
+    QVERIFY(board.canRedo());
+    board.movePiece(board.begin(), Direction::Yminus);
+    QVERIFY(!board.canRedo());
+    board.undo();
+    QVERIFY(board == step1);
+
+    // the operations without effect are not undo steps
+    board.beginTransaction();
+    board.commitTransaction();
+    board.undo();
+    QVERIFY(board == reference);
+    QVERIFY(!board.canUndo());
+  }
+
+  void testChunkedArray(void) {
+    ChunkedArray<quint32> a(1000, 7);
+    QVERIFY((a.size() == 1000) && (a.getNbChunks() == 16));
+    QVERIFY((a.at(0) == 7) && (a.at(999) == 7));
+
+    // a copy only duplicates the modified chunks
+    ChunkedArray<quint32> b(a);
+    QVERIFY(b.getNbSharedChunks(a) == 16);
+    b[500] = 3;
+    b[510] = 4;
+    QVERIFY((a.at(500) == 7) && (b.at(500) == 3) && (b.at(510) == 4));
+    QVERIFY(b.getNbSharedChunks(a) == 15);
+    QVERIFY(b.at(501) == 7);
+
+    // reading a non-const array does not copy the chunks
+    ChunkedArray<quint32> c(b);
+    quint32 sum = 0;
+    for(unsigned int i = 0; i != c.size(); ++i)
+      sum += c.at(i);
+    QVERIFY(sum == 998 * 7 + 3 + 4);
+    QVERIFY(c.getNbSharedChunks(b) == 16);
+
+    for(unsigned int i = 0; i != 100; ++i)
+      c.push_back(i);
+    QVERIFY((c.size() == 1100) && (c.getNbChunks() == 18));
+    QVERIFY((c.at(999) == 7) && (c.at(1000) == 0) && (c.at(1099) == 99));
+    QVERIFY(c.getNbSharedChunks(b) == 15);
+    QVERIFY(b.size() == 1000);
+  }
+
   void testSaveLoad(void) {
     int x = 10;
     Board board1(x, x, x, Coord(0, 0, 0), Coord(x - 1, x - 1, x - 1));
@@ -54,6 +54,40 @@ private slots:
     QVERIFY(b.inBorder(Coord(15, 0, 3)));
   }
 
+  void testOrientations(void) {
+    const Coord c(1, 2, 3);
+    const Coord t(5, -1, 2);
+    for(Orientation::Type o1 = 0; o1 != Orientation::nbOrientations; ++o1) {
+      const Angle::Type a1 = Orientation::getAngle(o1);
+      const Direction::Type d1 = Orientation::getDirection(o1);
+      QVERIFY(Orientation::get(d1, a1) == o1);
+
+      // inverse and compositions
+      const Orientation::Type i1 = Orientation::inverse(o1);
+      QVERIFY(c.getTransform(a1, d1).getTransform(Orientation::getAngle(i1), Orientation::getDirection(i1)) == c);
+      for(Orientation::Type o2 = 0; o2 != Orientation::nbOrientations; ++o2) {
+	const Orientation::Type o = Orientation::compose(o1, o2);
+	QVERIFY(c.getTransform(Orientation::getAngle(o2), Orientation::getDirection(o2)).getTransform(a1, d1) ==
+		c.getTransform(Orientation::getAngle(o), Orientation::getDirection(o)));
+      }
+
+      // batch transformation
+      QVector<Coord> coords;
+      for(int i = 0; i != 10; ++i)
+	coords.push_back(Coord(i, 2 * i - 3, 7 - i));
+      QVector<Coord> result(coords);
+      Coord::transform(result.data(), result.size(), a1, d1, t);
+      for(int i = 0; i != 10; ++i)
+	QVERIFY(result[i] == coords[i].getTransform(a1, d1, t));
+
+      // bounded box
+      Box b(Coord(1, 2, 3), Coord(4, 6, 5));
+      Box r(b.getCorner1().getTransform(a1, d1, t), b.getCorner1().getTransform(a1, d1, t));
+      r.add(b.getCorner2().getTransform(a1, d1, t));
+      QVERIFY(b.transform(a1, d1, t) == r);
+    }
+  }
+
 };
 
 
@@ -29,6 +29,7 @@
 #include "core/GenericPiece.hxx"
 #include "core/LPiece.hxx"
 #include "core/Face.hxx"
+#include "core/ShapeRegistry.hxx"
 
 
 class testFaces : public QObject {
@@ -86,6 +87,31 @@ private slots:
     QVERIFY(faces == pfaces);
   }
 
+  void testFaceRing(void) {
+    // a 3x3 ring: 8 voxels, 8 contacts
+    QVector<Coord> cds;
+    for(unsigned int x = 0; x != 3; ++x)
+      for(unsigned int y = 0; y != 3; ++y)
+	if ((x != 1) || (y != 1))
+	  cds.push_back(Coord(x, y, 0));
+    GenericPiece ring(cds, Coord(0, 0, 0), Direction::Xplus, Angle::A0);
+    QList<Face> faces = ring.getFaces();
+    QVERIFY(faces.size() == 6 * 8 - 2 * 8);
+    QVERIFY(faces.contains(Face(Coord(0, 1, 0), Direction::Xplus)));
+    QVERIFY(!faces.contains(Face(Coord(0, 0, 0), Direction::Xplus)));
+
+    // the same ring, with a voxel far away
+    cds.push_back(Coord(500, 500, 500));
+    GenericPiece sparse(cds, Coord(0, 0, 0), Direction::Xplus, Angle::A0);
+    QList<Face> sfaces = sparse.getFaces();
+    QVERIFY(sfaces.size() == faces.size() + 6);
+    for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d)
+      faces.push_back(Face(Coord(500, 500, 500), d));
+    std::sort(faces.begin(), faces.end());
+    std::sort(sfaces.begin(), sfaces.end());
+    QVERIFY(faces == sfaces);
+  }
+
   void testFaceAndEdges(void) {
     {
       const unsigned int size = 4;
@@ -114,6 +140,58 @@ private slots:
 
       QVERIFY(facesAndEdgesAll.first.size() == (size1 + size2 - 2) * 4 + 6);
       QVERIFY(facesAndEdgesAll.second.size() == (size1 + size2 - 1) * 8 + 4);
+
+      QList<Edge> edges, allEdges;
+      QVERIFY(p.getFacesAndEdges(edges, allEdges) == facesAndEdges.first);
+      QVERIFY(edges == facesAndEdges.second);
+      QVERIFY(allEdges == facesAndEdgesAll.second);
+    }
+  }
+
+  void testEdgesOfShapes(void) {
+    ShapeRegistry shapes;
+    unsigned int seed = 1;
+    for(unsigned int i = 0; i != 20; ++i) {
+      QVector<Coord> cds;
+      for(unsigned int j = 0; j != 12; ++j) {
+	seed = seed * 1103515245 + 12345;
+	Coord c((seed >> 8) % 4, (seed >> 12) % 4, (seed >> 16) % 3);
+	if (!cds.contains(c))
+	  cds.push_back(c);
+      }
+      GenericPiece p(cds, Coord((int)(i % 10) - 5, seed % 10, 3),
+		     (Direction::Type)(i % 6), (Angle::Type)((i / 6) % 4));
+
+      for(unsigned int flat = 0; flat != 2; ++flat) {
+	QPair<QList<Face>, QList<Edge> > fae = p.getFacesAndEdges(flat == 1);
+
+	// reference: the faces adjacent to each edge
+	QMap<Edge, QList<Face> > map;
+	foreach(const Face & face, fae.first) {
+	  QList<Edge> edges = face.getEdges();
+	  for(QList<Edge>::const_iterator e = edges.begin(); e != edges.end(); ++e)
+	    map[(*e).getNormalize()].push_back(face);
+	}
+	QList<Edge> expected;
+	for(QMap<Edge, QList<Face> >::const_iterator e = map.begin(); e != map.end(); ++e)
+	  if (((*e).size() != 2) || (flat == 0) ||
+	      !((*e)[0].getDirection() == (*e)[1].getDirection() ||
+		Direction::areOpposite((*e)[0].getDirection(), (*e)[1].getDirection())))
+	    expected.push_back(e.key());
+
+	QList<Edge> edges = fae.second;
+	std::sort(edges.begin(), edges.end());
+	QVERIFY(edges == expected);
+
+	// same faces and edges from the registry
+	QPair<QList<Face>, QList<Edge> > sfae = shapes.getFacesAndEdges(shapes.getPlacement(p), flat == 1);
+	QList<Face> faces = fae.first;
+	std::sort(faces.begin(), faces.end());
+	std::sort(sfae.first.begin(), sfae.first.end());
+	std::sort(sfae.second.begin(), sfae.second.end());
+	QVERIFY(sfae.first == faces);
+	QVERIFY(sfae.second == expected);
+      }
     }
   }
 };
@@ -26,6 +26,8 @@
 
 #include "core/Board.hxx"
 #include "core/Pattern.hxx"
+#include "core/Generator.hxx"
+#include "core/StraightPiece.hxx"
 
 class testPatterns : public QObject {
   Q_OBJECT
@@ -60,6 +62,61 @@ private slots:
 
   }
 
+  void testIntersection(void) {
+    QVector<Direction::Type> steps;
+    for(unsigned int i = 0; i != 20; ++i)
+      steps.push_back(i % 2 == 0 ? Direction::Xplus : Direction::Yplus);
+    steps.push_back(Direction::Zplus);
+    Pattern pattern = Pattern::pipe(Coord(1, 1, 1), steps);
+    QVERIFY(pattern.getPieces().size() > 100);
+    QVERIFY(!pattern.hasIntersection());
+
+    pattern.addPiece(StraightPiece(3, Coord(0, 0, 1), Direction::Xplus));
+    QVERIFY(pattern.hasIntersection());
+
+    // sparse pattern
+    Pattern sparse;
+    sparse.addPiece(StraightPiece(2, Coord(0, 0, 0), Direction::Xplus));
+    sparse.addPiece(StraightPiece(2, Coord(1000, 1000, 1000), Direction::Xplus));
+    QVERIFY(!sparse.hasIntersection());
+    sparse.addPiece(StraightPiece(2, Coord(1001, 999, 1000), Direction::Yplus));
+    QVERIFY(sparse.hasIntersection());
+  }
+
+  void testNestedPatterns(void) {
+    const Coord c(3, 1, 2);
+    for(Direction::Type d = Direction::Xplus; d != Direction::Static; ++d)
+      for(unsigned int k = 0; k != 4; ++k) {
+	const Angle::Type a = (Angle::Type)k;
+	Pattern inner = Pattern::turning(3, 3, Coord(1, 0, 2), Direction::Yplus, Angle::A90);
+	Pattern outer(c, d, a);
+	outer.addPattern(inner);
+	outer.addPiece(StraightPiece(2, Coord(-1, -1, -1), Direction::Zplus));
+
+	// reference: the global pieces of the inner pattern, transformed
+	QVector<QSharedPointer<Piece> > expected = inner.getPieces();
+	expected.push_back(QSharedPointer<Piece>(new StraightPiece(2, Coord(-1, -1, -1), Direction::Zplus)));
+	QVector<QSharedPointer<Piece> > pieces = outer.getPieces();
+	QVERIFY(pieces.size() == expected.size());
+	Box box = (*pieces.front()).getBoundedBox();
+	for(int i = 0; i != pieces.size(); ++i) {
+	  (*expected[i]).transform(a, d, c);
+	  QVERIFY((*pieces[i]).getVoxels() == (*expected[i]).getVoxels());
+	  box.add((*pieces[i]).getBoundedBox());
+	}
+	QVERIFY(box == outer.getBoundedBox());
+	QVERIFY(!outer.hasIntersection());
+
+	// a copy gives the same pieces, in new objects
+	Pattern copy(outer);
+	QVector<QSharedPointer<Piece> > cpieces = copy.getPieces();
+	for(int i = 0; i != pieces.size(); ++i) {
+	  QVERIFY(cpieces[i] != pieces[i]);
+	  QVERIFY((*cpieces[i]) == (*pieces[i]));
+	}
+      }
+  }
+
   void testPipe1(void) {
     Board board(3, 6, 3, Coord(0, 1, 1), Coord(2, 4, 1));
 
@@ -170,4 +227,30 @@ private slots:
     QVERIFY(board.checkInternalMemoryState());
   }
 
+  void testGenerator(void) {
+    Generator generator(3, 2, 2, Coord(0, 0, 0), Direction::Xminus,
+			Coord(2, 1, 1), Direction::Zplus);
+    generator.setMinLength(6);
+
+    Board board;
+    QVERIFY(generator.generate(board, 1));
+    QVERIFY(board.validWindows());
+    QVERIFY(board.isStableAndValid());
+    QVERIFY(board.hasPathBetweenWindows());
+    QVERIFY(board.checkInternalMemoryState());
+
+    QVector<Board> boards = generator.generate(4, 2, 1);
+    QVERIFY(boards.size() == 4);
+    QVERIFY(boards.front() == board);
+
+    // a single path of minimal length: many boards are equal up to a rotation
+    generator.setMinLength(1).setUnique(true);
+    boards = generator.generate(16, 4, 1);
+    QVERIFY(!boards.isEmpty());
+    QSet<quint64> hashes;
+    for(QVector<Board>::const_iterator b = boards.begin(); b != boards.end(); ++b)
+      hashes.insert((*b).getCanonicalHash());
+    QVERIFY(hashes.size() == boards.size());
+  }
+
 };
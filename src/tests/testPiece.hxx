@@ -22,11 +22,14 @@
 #include <QObject>
 #include <QtTest>
 #include <QtCore>
+#include <algorithm>
 
 #include "core/Piece.hxx"
 #include "core/StraightPiece.hxx"
 #include "core/LPiece.hxx"
 #include "core/GenericPiece.hxx"
+#include "core/ShapeRegistry.hxx"
+#include "core/AbstractPiece.hxx"
 
 
 class testPiece : public QObject {
@@ -130,6 +133,118 @@ private slots:
   }
 
 
+  void testCachedVoxels(void) {
+    LPiece p(4, 3, Coord(1, 2, 3), Direction::Yplus, Angle::A90);
+    for(unsigned int step = 0; step != 8; ++step) {
+      switch(step % 4) {
+      case 0: p.move(Direction::Zminus, 2); break;
+      case 1: p.rotate(Direction::Xplus); break;
+      case 2: p.transform(Angle::A270, Direction::Zplus, Coord(1, 0, 0)); break;
+      default: p.resetTransform().move(Direction::Yplus); break;
+      }
+      // the cached voxels and box are the transformed ones
+      QVERIFY(p.getVoxels().size() == (int)p.nbVoxels());
+      unsigned int i = 0;
+      for(Piece::const_iterator c = p.begin(); c != p.end(); ++c, ++i)
+	QVERIFY(*c == p.getCoordById(i));
+      QVERIFY(p.getBoundedBox() == p.getLocalBoundedBox().transform(p.getAngle(), p.getDirection(), p.getLocation()));
+    }
+  }
+
+  void testTransform(void) {
+    LPiece p(4, 3, Coord(1, 2, 3), Direction::Yplus, Angle::A90);
+    for(Orientation::Type o = 0; o != Orientation::nbOrientations; ++o) {
+      const Angle::Type a = Orientation::getAngle(o);
+      const Direction::Type d = Orientation::getDirection(o);
+      // the voxels of the transformed piece are the transformed voxels
+      LPiece q(p);
+      q.transform(a, d, Coord(2, 0, -1));
+      QVector<Coord> v1;
+      for(Piece::const_iterator c = p.begin(); c != p.end(); ++c)
+	v1.push_back((*c).getTransform(a, d, Coord(2, 0, -1)));
+      QVector<Coord> v2 = q.getVoxels();
+      std::sort(v1.begin(), v1.end());
+      std::sort(v2.begin(), v2.end());
+      QVERIFY(v1 == v2);
+    }
+  }
+
+  void testIntersect(void) {
+    // the bounded boxes intersect, but not the voxels
+    QVector<Coord> c1;
+    c1.push_back(Coord(0, 0, 0));
+    c1.push_back(Coord(1, 0, 0));
+    c1.push_back(Coord(2, 0, 0));
+    c1.push_back(Coord(0, 1, 0));
+    c1.push_back(Coord(0, 2, 0));
+    QVector<Coord> c2;
+    c2.push_back(Coord(1, 1, 0));
+    c2.push_back(Coord(2, 1, 0));
+    c2.push_back(Coord(2, 2, 0));
+    const GenericPiece l1(c1, Coord(0, 0, 0));
+    const GenericPiece l2(c2, Coord(0, 0, 0));
+    QVERIFY(l1.getBoundedBox().intersects(l2.getBoundedBox()));
+    QVERIFY(!l1.intersect(l2) && !l2.intersect(l1));
+    QVERIFY(l1.intersect(GenericPiece(c2, Coord(-1, 0, 0))));
+    QVERIFY(!l1.intersect(StraightPiece(3, Coord(0, 0, 1), Direction::Xplus)));
+    QVERIFY(l1.intersect(StraightPiece(3, Coord(0, 2, 0), Direction::Xplus)));
+
+    // sparse pieces
+    QVector<Coord> coords;
+    coords.push_back(Coord(0, 0, 0));
+    coords.push_back(Coord(1000, 1000, 1000));
+    const GenericPiece sparse(coords, Coord(0, 0, 0));
+    QVERIFY(sparse.intersect(StraightPiece(2, Coord(999, 1000, 1000), Direction::Xplus)));
+    QVERIFY(!sparse.intersect(StraightPiece(2, Coord(999, 999, 1000), Direction::Xplus)));
+    QVERIFY(sparse.intersect(GenericPiece(coords, Coord(0, 0, 0))));
+    QVERIFY(!sparse.intersect(GenericPiece(coords, Coord(1, 0, 0))));
+
+    // comparison with all the pairs of voxels
+    quint32 seed = 12345;
+    for(unsigned int t = 0; t != 200; ++t) {
+      QVector<Coord> r1, r2;
+      for(unsigned int i = 0; i != 6; ++i) {
+	seed = seed * 1664525 + 1013904223;
+	r1.push_back(Coord((seed >> 8) % 3, (seed >> 12) % 3, (seed >> 16) % 3));
+	seed = seed * 1664525 + 1013904223;
+	r2.push_back(Coord((seed >> 8) % 3, (seed >> 12) % 3, (seed >> 16) % (t < 100 ? 3 : 200)));
+      }
+      const GenericPiece p1(r1, Coord(0, 0, 0));
+      const GenericPiece p2(r2, Coord(0, 0, 0));
+      bool expected = false;
+      for(QVector<Coord>::const_iterator v1 = r1.begin(); v1 != r1.end(); ++v1)
+	expected = expected || r2.contains(*v1);
+      QVERIFY(p1.intersect(p2) == expected);
+      QVERIFY(p2.intersect(p1) == expected);
+    }
+  }
+
+  void testShapeRegistry(void) {
+    ShapeRegistry shapes;
+    QVector<Coord> coords;
+    coords.push_back(Coord(2, 0, 0));
+    coords.push_back(Coord(0, 0, 0));
+    coords.push_back(Coord(1, 0, 0));
+    const unsigned int s1 = shapes.add(StraightPiece(3, Coord(4, 5, 6), Direction::Zminus));
+    QVERIFY(shapes.add(GenericPiece(coords, Coord(0, 0, 0))) == s1);
+    QVERIFY(shapes.getId(LPiece(3, 2, Coord(0, 0, 0))) == -1);
+    const unsigned int s2 = shapes.add(LPiece(3, 2, Coord(0, 0, 0)));
+    QVERIFY((s1 != s2) && (shapes.getNbShapes() == 2));
+    QVERIFY(shapes.getNbVoxels(s2) == 4);
+    QVERIFY(sizeof(ShapeRegistry::Placement) <= 10);
+
+    // the placements have the voxels of the pieces
+    for(Orientation::Type o = 0; o != Orientation::nbOrientations; ++o) {
+      LPiece p(3, 2, Coord(1, -2, 3), Orientation::getDirection(o), Orientation::getAngle(o));
+      const ShapeRegistry::Placement placement = shapes.getPlacement(p);
+      QVERIFY((placement.getShape() == s2) && (placement.getOrientation() == o));
+      QVERIFY(shapes.getVoxels(placement) == p.getVoxels());
+      QVERIFY(shapes.getBoundedBox(placement) == p.getBoundedBox());
+      QSharedPointer<Piece> q(shapes.createPiece(placement));
+      QVERIFY(*q == p);
+    }
+  }
+
   void testIteratorOnBoundedBox(void) {
     {
       StraightPiece p(4, Coord(0, 0, 0), Direction::Xplus);
@@ -176,4 +291,61 @@ private slots:
         QVERIFY(b.contains(*c));
     }
   }
+
+  void testSignature(void) {
+    // an L shape, given with two voxel orders, and rotated
+    QVector<Coord> cds;
+    cds.push_back(Coord(0, 0, 0));
+    cds.push_back(Coord(1, 0, 0));
+    cds.push_back(Coord(2, 0, 0));
+    cds.push_back(Coord(2, 1, 0));
+    QVector<Coord> reversed(cds);
+    std::reverse(reversed.begin(), reversed.end());
+    QVector<Coord> rotated;
+    for(QVector<Coord>::const_iterator c = cds.begin(); c != cds.end(); ++c)
+      rotated.push_back(Coord(-(*c).getY(), 3, (*c).getX()));
+
+    GenericPiece g1(cds, Coord(0, 0, 0));
+    GenericPiece g2(reversed, Coord(4, 2, 1), Direction::Zminus, Angle::A90);
+    GenericPiece g3(rotated, Coord(0, 0, 0));
+    QVERIFY(!g1.isSimilar(g2));
+    QVERIFY(g1.getSignature() == g2.getSignature());
+    QVERIFY(g1.getSignature() == g3.getSignature());
+    QVERIFY(g1.getSignature().size() == 4);
+
+    // a chiral shape and its mirror
+    QVector<Coord> twist;
+    twist.push_back(Coord(0, 0, 0));
+    twist.push_back(Coord(1, 0, 0));
+    twist.push_back(Coord(1, 1, 0));
+    twist.push_back(Coord(1, 1, 1));
+    GenericPiece t1(twist, Coord(0, 0, 0));
+    twist[3] = Coord(1, 1, -1);
+    GenericPiece t2(twist, Coord(0, 0, 0));
+    QVERIFY(t1.getSignature() != t2.getSignature());
+    QVERIFY(g1.getSignature() != StraightPiece(4, Coord(0, 0, 0)).getSignature());
+
+    QVector<QSharedPointer<Piece> > pieces;
+    pieces.push_back(QSharedPointer<Piece>(g1.clone()));
+    pieces.push_back(QSharedPointer<Piece>(new StraightPiece(5, Coord(1, 1, 1), Direction::Zplus)));
+    pieces.push_back(QSharedPointer<Piece>(g2.clone()));
+    pieces.push_back(QSharedPointer<Piece>(new StraightPiece(5, Coord(0, 0, 0), Direction::Yminus)));
+    pieces.push_back(QSharedPointer<Piece>(g3.clone()));
+    QMap<AbstractPiece, unsigned int> groups = Piece::groupBySimilarity(pieces);
+    QVERIFY(groups.size() == 2);
+    for(QMap<AbstractPiece, unsigned int>::const_iterator g = groups.begin(); g != groups.end(); ++g)
+      QVERIFY(*g == ((*(g.key())).nbVoxels() == 4 ? 3u : 2u));
+
+    // same bounding box and number of voxels, distinct shapes
+    QVERIFY(t1 < t2 || t2 < t1);
+    QVERIFY(!(t1 < t1));
+    pieces.clear();
+    pieces.push_back(QSharedPointer<Piece>(t1.clone()));
+    pieces.push_back(QSharedPointer<Piece>(t2.clone()));
+    pieces.push_back(QSharedPointer<Piece>(t1.clone()));
+    groups = Piece::groupBySimilarity(pieces);
+    QVERIFY(groups.size() == 2);
+    for(QMap<AbstractPiece, unsigned int>::const_iterator g = groups.begin(); g != groups.end(); ++g)
+      QVERIFY(*g == ((*(g.key())).getSignature() == t1.getSignature() ? 2u : 1u));
+  }
 };
@@ -0,0 +1,187 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+#include <QObject>
+#include <QtTest>
+#include <QtCore>
+#include <algorithm>
+
+#include "core/Board.hxx"
+#include "core/ExactCover.hxx"
+#include "core/Solver.hxx"
+#include "core/SolutionCounter.hxx"
+#include "core/StraightPiece.hxx"
+#include "core/LPiece.hxx"
+
+/** store the solutions */
+class SolutionList : public ExactCover::Listener {
+public:
+  QVector<QVector<unsigned int> > solutions;
+
+  bool onSolution(const QVector<unsigned int> & rows) {
+    solutions.push_back(rows);
+    return true;
+  }
+};
+
+/** count the valid boards */
+class BoardCounter : public Solver::Listener {
+public:
+  unsigned int nbBoards;
+  unsigned int nbValidBoards;
+
+  BoardCounter() : nbBoards(0), nbValidBoards(0) { }
+
+  bool onSolution(const Board & board) {
+    ++nbBoards;
+    if (board.isValid() && board.checkInternalMemoryState())
+      ++nbValidBoards;
+    return true;
+  }
+};
+
+class testSolver : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testExactCover(void) {
+    // Knuth's example
+    ExactCover problem(7);
+    QVector<unsigned int> r;
+    r << 2 << 4 << 5;
+    problem.addRow(r);
+    r.clear(); r << 0 << 3 << 6;
+    problem.addRow(r);
+    r.clear(); r << 1 << 2 << 5;
+    problem.addRow(r);
+    r.clear(); r << 0 << 3;
+    problem.addRow(r);
+    r.clear(); r << 1 << 6;
+    problem.addRow(r);
+    r.clear(); r << 3 << 4 << 6;
+    problem.addRow(r);
+
+    SolutionList list;
+    QVERIFY(problem.search(list) == 1);
+    QVector<unsigned int> s = list.solutions.front();
+    std::sort(s.begin(), s.end());
+    QVERIFY((s.size() == 3) && (s[0] == 0) && (s[1] == 3) && (s[2] == 4));
+  }
+
+  void testGroups(void) {
+    // three columns, covered by single rows of the same group
+    ExactCover problem(3);
+    const unsigned int g = problem.addGroup(2);
+    for(unsigned int i = 0; i != 3; ++i) {
+      QVector<unsigned int> r;
+      r << i;
+      problem.addRow(r, g);
+    }
+    QVector<unsigned int> r;
+    r << 0 << 1;
+    problem.addRow(r);
+
+    SolutionList list;
+    QVERIFY(problem.search(list) == 1);
+    QVERIFY(list.solutions.front().size() == 2);
+  }
+
+  void testOrientations(void) {
+    QVERIFY(Solver::getOrientations(StraightPiece(1, Coord(0, 0, 0))).size() == 1);
+    QVERIFY(Solver::getOrientations(StraightPiece(3, Coord(0, 0, 0))).size() == 3);
+    QVERIFY(Solver::getOrientations(LPiece(2, 2, Coord(0, 0, 0))).size() == 12);
+    QVERIFY(Solver::getOrientations(LPiece(3, 2, Coord(0, 0, 0))).size() == 24);
+  }
+
+  void testFilling(void) {
+    {
+      // a cycle of 6 voxels
+      Solver solver(2, 2, 2, Coord(0, 0, 0), Coord(1, 1, 1));
+      solver.addPiece(StraightPiece(2, Coord(0, 0, 0)), 2);
+      solver.addPiece(StraightPiece(2, Coord(4, 4, 4), Direction::Zminus));
+      QVERIFY(solver.getNbShapes() == 1);
+      BoardCounter counter;
+      QVERIFY(solver.solve(counter) == 2);
+      QVERIFY(counter.nbValidBoards == 2);
+    }
+
+    {
+      QVector<Coord> path;
+      for(unsigned int z = 0; z != 4; ++z)
+	path.push_back(Coord(0, 0, z));
+      Solver solver(4, 4, 4, Coord(0, 0, 0), Coord(0, 0, 3), path);
+      solver.addPiece(LPiece(2, 2, Coord(0, 0, 0)), 20);
+      Board board;
+      QVERIFY(solver.solve(board));
+      QVERIFY(board.getNbPieces() == 20);
+      QVERIFY(board.isValid());
+      QVERIFY(board.hasPathBetweenWindows());
+    }
+
+    {
+      Solver solver(2, 2, 2, Coord(0, 0, 0), Coord(1, 1, 1));
+      solver.addPiece(StraightPiece(3, Coord(0, 0, 0)), 2);
+      Board board;
+      QVERIFY(!solver.solve(board));
+    }
+  }
+
+  void testCounting(void) {
+    // a path along the axis of a 3x3x3 board, filled with L pieces
+    QVector<Coord> path;
+    for(unsigned int z = 0; z != 3; ++z)
+      path.push_back(Coord(1, 1, z));
+    Solver solver(3, 3, 3, Coord(1, 1, 0), Coord(1, 1, 2), path);
+    solver.addPiece(LPiece(2, 2, Coord(0, 0, 0)), 8);
+
+    SolutionCounter counter(solver);
+    QVERIFY(counter.getNbSymmetries() == 8);
+    QVERIFY(counter.count() == 23);
+    // the placements covering a voxel are restricted by its 2 symmetries
+    QVERIFY(counter.getNbBoards() == 72);
+    QVERIFY(!counter.hasUniqueSolution());
+    QVERIFY(counter.getSolutions().size() == 2);
+    counter.setLimit(5);
+    QVERIFY(counter.count() == 5);
+
+    // the same problem, described by one of its solutions
+    SolutionCounter other(counter.getSolutions().front());
+    QVERIFY(other.getNbSymmetries() == 8);
+    QVERIFY(other.count() == 23);
+
+    // the placements of a piece available once are restricted by the 8 symmetries
+    Solver mixed(3, 3, 3, Coord(1, 1, 0), Coord(1, 1, 2), path);
+    mixed.addPiece(LPiece(2, 2, Coord(0, 0, 0)), 7);
+    mixed.addPiece(StraightPiece(3, Coord(0, 0, 0)));
+    SolutionCounter restricted(mixed);
+    QVERIFY(restricted.count() == 119);
+    QVERIFY(restricted.getNbBoards() == 148);
+
+    // the pieces of the cycle can be moved
+    Solver cycle(2, 2, 2, Coord(0, 0, 0), Coord(1, 1, 1));
+    cycle.addPiece(StraightPiece(2, Coord(0, 0, 0)), 3);
+    SolutionCounter empty(cycle);
+    QVERIFY(empty.getNbSymmetries() == 6);
+    QVERIFY(empty.count() == 0);
+  }
+
+};
@@ -0,0 +1,140 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+#include <QObject>
+#include <QtTest>
+#include <QtCore>
+
+#include "core/TranspositionTable.hxx"
+
+/** insert keys in a shared table */
+class TableThread : public QThread {
+private:
+  TranspositionTable & table;
+  unsigned int nbKeys;
+public:
+  /** number of keys reported as new to this thread */
+  unsigned int nbInserted;
+
+  TableThread(TranspositionTable & t, unsigned int nb) : table(t), nbKeys(nb), nbInserted(0) { }
+
+protected:
+  void run() {
+    for(unsigned int i = 0; i != nbKeys; ++i)
+      if (table.insert((quint64)i * 0xD6E8FEB86659FD93ull, i))
+	++nbInserted;
+  }
+};
+
+class testTranspositionTable : public QObject {
+  Q_OBJECT
+
+private slots:
+  void testInsertAndFind(void) {
+    TranspositionTable table(4);
+    QVERIFY(table.getNbEntries() == 16 * TranspositionTable::bucketSize);
+    QVERIFY(table.insert(1, 3, 1));
+    QVERIFY(!table.insert(1, 4, 2));
+    quint32 value;
+    unsigned int depth;
+    QVERIFY(table.find(1, value, depth) && (value == 4) && (depth == 2));
+    QVERIFY(!table.contains(17));
+
+    // all the keys are valid, including 0
+    QVERIFY(!table.contains(0));
+    QVERIFY(table.insert(0, 7) && table.contains(0));
+    QVERIFY(!table.contains(0x9E3779B97F4A7C15ull));
+    QVERIFY(table.insert(0x9E3779B97F4A7C15ull, 8));
+    QVERIFY(table.find(0, value, depth) && (value == 7));
+    QVERIFY(table.find(0x9E3779B97F4A7C15ull, value, depth) && (value == 8));
+
+    // large depths are truncated
+    QVERIFY(!table.insert(1, 4, 0xFFFFFFFF));
+    QVERIFY(table.find(1, value, depth) && (depth == TranspositionTable::maxDepth));
+  }
+
+  void testReplacement(void) {
+    TranspositionTable table(4);
+    quint32 value;
+    unsigned int depth;
+
+    // a full bucket: the entry with the smallest depth is replaced
+    QVERIFY(table.insert(1, 0, 1));
+    for(unsigned int i = 1; i != 4; ++i)
+      QVERIFY(table.insert(1 + i * 16, i, 10 + i));
+    QVERIFY(table.insert(65, 0, 5));
+    QVERIFY(!table.contains(1));
+    QVERIFY(table.contains(17) && table.contains(33) && table.contains(49) && table.contains(65));
+    QVERIFY(!table.insert(65, 2, 6));
+    QVERIFY(table.find(65, value, depth) && (value == 2) && (depth == 6));
+    table.clear();
+    QVERIFY(!table.contains(17));
+  }
+
+  void testConcurrentInsertions(void) {
+    // concurrent insertions of the same keys
+    TranspositionTable shared(16);
+    QVector<QSharedPointer<TableThread> > threads;
+    for(unsigned int i = 0; i != 4; ++i)
+      threads.push_back(QSharedPointer<TableThread>(new TableThread(shared, 20000)));
+    for(QVector<QSharedPointer<TableThread> >::iterator t = threads.begin(); t != threads.end(); ++t)
+      (**t).start();
+    unsigned int nbInserted = 0;
+    for(QVector<QSharedPointer<TableThread> >::iterator t = threads.begin(); t != threads.end(); ++t) {
+      (**t).wait();
+      nbInserted += (**t).nbInserted;
+    }
+    // a key may be reported as new to several threads
+    QVERIFY(nbInserted >= 20000);
+    quint32 value;
+    unsigned int depth;
+    for(unsigned int i = 0; i != 20000; ++i)
+      QVERIFY(shared.find((quint64)i * 0xD6E8FEB86659FD93ull, value, depth) && (value == i));
+  }
+
+  void testConcurrentReplacements(void) {
+    // the same key inserted by several threads in a full bucket
+    for(unsigned int round = 0; round != 50; ++round) {
+      TranspositionTable table(0);
+      for(unsigned int i = 0; i != TranspositionTable::bucketSize; ++i)
+	QVERIFY(table.insert(1000 + i, 0, 10));
+      QVector<QSharedPointer<TableThread> > threads;
+      for(unsigned int i = 0; i != 8; ++i)
+	threads.push_back(QSharedPointer<TableThread>(new TableThread(table, 1)));
+      for(QVector<QSharedPointer<TableThread> >::iterator t = threads.begin(); t != threads.end(); ++t)
+	(**t).start();
+      unsigned int nbInserted = 0;
+      for(QVector<QSharedPointer<TableThread> >::iterator t = threads.begin(); t != threads.end(); ++t) {
+	(**t).wait();
+	nbInserted += (**t).nbInserted;
+      }
+      // the key 0 replaces one entry
+      QVERIFY(nbInserted >= 1);
+      QVERIFY(table.contains(0));
+      unsigned int nbKept = 0;
+      for(unsigned int i = 0; i != TranspositionTable::bucketSize; ++i)
+	if (table.contains(1000 + i))
+	  ++nbKept;
+      QVERIFY(nbKept == TranspositionTable::bucketSize - 1);
+    }
+  }
+};
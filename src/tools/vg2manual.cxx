@@ -26,6 +26,7 @@
 
 #include "core/export/Manual.hxx"
 #include "core/Board.hxx"
+#include "core/SolutionCounter.hxx"
 
 int main(int argc, char** argv)
 {
@@ -62,6 +63,7 @@ int main(int argc, char** argv)
     out << Qt::endl;
     out << "  -2, --two-sides  The generated pages are two-side pages (for a recto/verso printing)" << Qt::endl;
     out << "  -c, --colors     Create a colored document" << Qt::endl;
+    out << "  -u, --unique     Check that the pieces of the board fill it in a unique way (up to symmetries)" << Qt::endl;
     out << "  -f, --force      Force manual creation even for non valid boards" << Qt::endl;
     out << "  -h, --help       Print this help message" << Qt::endl;
     out << Qt::endl;
@@ -86,6 +88,7 @@ int main(int argc, char** argv)
   bool substeps = true;
   bool usecolor = false;
   bool force = false;
+  bool unique = false;
 
   // load parameters
   for(unsigned int i = 1; i != (unsigned int) args.size(); ++i) {
@@ -135,6 +138,9 @@ int main(int argc, char** argv)
       else if ((s == "-f") || (s == "--force")) {
 	force = true;
       }
+      else if ((s == "-u") || (s == "--unique")) {
+	unique = true;
+      }
       else if ((s == "-c") || (s == "--colors")) {
 	usecolor = true;
       }
@@ -234,6 +240,24 @@ int main(int argc, char** argv)
     }
   }
 
+  if (unique) {
+    out << "Checking the uniqueness of the solution" << Qt::endl;
+    SolutionCounter counter(board);
+    const unsigned int nb = counter.setLimit(2).count();
+    if (nb != 1) {
+      if (nb == 0)
+	err << "Error: the pieces of this board have no solution. ";
+      else
+	err << "Error: the pieces of this board have several solutions. ";
+      if (force)
+	err << "Continue (--force option)" << Qt::endl;
+      else {
+	err << "Abort." << Qt::endl;
+	return 4;
+      }
+    }
+  }
+
   Manual manual(board);
   manual.setLevel(level);
   manual.setId(id);
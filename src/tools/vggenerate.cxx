@@ -0,0 +1,256 @@
+/*****************************************************************************
+    This file is part of Voxigame.
+
+    Copyright (C) 2011 Jean-Marie Favreau <J-Marie.Favreau@u-clermont1.fr>
+                       Université d'Auvergne (France)
+
+    Voxigame is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Voxigame is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Foobar.  If not, see <http://www.gnu.org/licenses/>.
+
+ *****************************************************************************/
+
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+
+#include "core/Generator.hxx"
+#include "core/Board.hxx"
+
+/** read a window description (X,Y,Z,FACE). Return false if the description is not valid */
+static bool readWindow(const QString & s, Coord & cell, Direction::Type & face) {
+  QStringList values = s.split(",");
+  if (values.size() != 4)
+    return false;
+  bool okx, oky, okz;
+  cell = Coord(values[0].toUInt(&okx), values[1].toUInt(&oky), values[2].toUInt(&okz));
+  if (!okx || !oky || !okz)
+    return false;
+  try {
+    face = Direction::fromString(values[3]);
+  }
+  catch (Exception &) {
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  QCoreApplication app(argc, argv);
+  QStringList args;
+
+  args = app.arguments();
+
+  if (args.size() <= 1) {
+    out << "Parameters required. See help (--help)" << Qt::endl;
+    return 1;
+  }
+  if (args.contains("--help") ||
+      args.contains("-h")) {
+    out << "Generate static voxigame boards with a path between two windows." << Qt::endl;
+    out << " Usage: vggenerate [parameters] SX SY SZ OUTPUT" << Qt::endl;
+    out << Qt::endl;
+    out << " Parameters:" << Qt::endl;
+    out << "  -1, --window1=X,Y,Z,F  Cell and face (x, -x, y, -y, z or -z) of the input window" << Qt::endl;
+    out << "                         (default: 0,0,0,-x)" << Qt::endl;
+    out << "  -2, --window2=X,Y,Z,F  Cell and face of the output window (default: SX-1,SY-1,SZ-1,x)" << Qt::endl;
+    out << "  -l, --min-length=L     Minimal number of cells of the path" << Qt::endl;
+    out << "  -n, --number=N         Number of generated boards. If N > 1, the output names are OUTPUT<number>.vg" << Qt::endl;
+    out << "  -t, --threads=T        Number of threads (default: number of cores)" << Qt::endl;
+    out << "  -s, --seed=S           Seed of the first board" << Qt::endl;
+    out << "  --tries=T              Maximal number of routed paths for a board" << Qt::endl;
+    out << "  --no-group-check       Only check single pieces for mobility" << Qt::endl;
+    out << "  -u, --unique           Remove the boards equal to another one up to a rotation" << Qt::endl;
+    out << "  -h, --help             Print this help message" << Qt::endl;
+    out << Qt::endl;
+    out << " The value of an option is given either after \"=\" or as the next argument." << Qt::endl;
+    out << " SX, SY, SZ: size of the board, in cells of 3x3x3 voxels." << Qt::endl;
+    out << " OUTPUT: the generated voxigame file (or prefix)." << Qt::endl;
+    return 0;
+  }
+
+  QStringList values;
+  QString output;
+  QString window1;
+  QString window2;
+  unsigned int minLength = 1;
+  unsigned int number = 1;
+  unsigned int threads = qMax(1, QThread::idealThreadCount());
+  unsigned int seed = 0;
+  unsigned int tries = 100;
+  bool stable = true;
+  bool unique = false;
+
+  // load parameters
+  for(unsigned int i = 1; i != (unsigned int) args.size(); ++i) {
+    QString s = args[i];
+    // a long option may carry its value (--option=value)
+    QString value;
+    bool hasValue = false;
+    if (s.startsWith("--") && s.contains("=")) {
+      const int e = s.indexOf("=");
+      value = s.mid(e + 1);
+      s = s.left(e);
+      hasValue = true;
+    }
+    if (s[0] == '-') {
+      if ((s == "-h") || (s == "--help"))
+	continue;
+      else if ((s == "-1") || (s == "--window1") ||
+	       (s == "-2") || (s == "--window2")) {
+	if (!hasValue) {
+	  ++i;
+	  if (i == (unsigned int)args.size()) {
+	    err << "Error: no given window (" + s + ")" << Qt::endl;
+	    err << "Abort." << Qt::endl;
+	    return 1;
+	  }
+	  value = args[i];
+	}
+	if ((s == "-1") || (s == "--window1"))
+	  window1 = value;
+	else
+	  window2 = value;
+      }
+      else if ((s == "-l") || (s == "--min-length") ||
+	       (s == "-n") || (s == "--number") ||
+	       (s == "-t") || (s == "--threads") ||
+	       (s == "-s") || (s == "--seed") ||
+	       (s == "--tries")) {
+	if (!hasValue) {
+	  ++i;
+	  if (i == (unsigned int)args.size()) {
+	    err << "Error: no given value (" + s + ")" << Qt::endl;
+	    err << "Abort." << Qt::endl;
+	    return 1;
+	  }
+	  value = args[i];
+	}
+	bool ok;
+	const unsigned int v = value.toUInt(&ok);
+	if (!ok) {
+	  err << "Error: Wrong value (" + s + "). It should be a positive integer." << Qt::endl;
+	  err << "Abort." << Qt::endl;
+	  return 1;
+	}
+	if ((s == "-l") || (s == "--min-length"))
+	  minLength = v;
+	else if ((s == "-n") || (s == "--number"))
+	  number = v;
+	else if ((s == "-t") || (s == "--threads"))
+	  threads = v;
+	else if ((s == "-s") || (s == "--seed"))
+	  seed = v;
+	else
+	  tries = v;
+      }
+      else if (hasValue &&
+	       ((s == "--no-group-check") || (s == "--unique"))) {
+	err << "Error: this parameter has no value (" << s << ")" << Qt::endl;
+	err << "Abort." << Qt::endl;
+	return 1;
+      }
+      else if (s == "--no-group-check") {
+	stable = false;
+      }
+      else if ((s == "-u") || (s == "--unique")) {
+	unique = true;
+      }
+      else {
+	err << "Error: unknown parameter (" << s << ")" << Qt::endl;
+	err << "Abort." << Qt::endl;
+	return 1;
+      }
+    }
+    else {
+      if (values.size() < 3)
+	values.push_back(s);
+      else if (output == "")
+	output = s;
+      else {
+	err << "Error: unknown parameter (" << s << ")" << Qt::endl;
+	err << "Abort." << Qt::endl;
+	return 1;
+      }
+    }
+  }
+
+  if (output == "") {
+    err << "Error: size and output file are required" << Qt::endl;
+    err << "Abort." << Qt::endl;
+    return 1;
+  }
+
+  unsigned int size[3];
+  for(unsigned int i = 0; i != 3; ++i) {
+    bool ok;
+    size[i] = values[i].toUInt(&ok);
+    if (!ok || (size[i] == 0)) {
+      err << "Error: Wrong size (" << values[i] << "). It should be an integer >= 1." << Qt::endl;
+      err << "Abort." << Qt::endl;
+      return 1;
+    }
+  }
+
+  Coord cell1(0, 0, 0);
+  Direction::Type face1 = Direction::Xminus;
+  Coord cell2(size[0] - 1, size[1] - 1, size[2] - 1);
+  Direction::Type face2 = Direction::Xplus;
+  if ((window1 != "") && !readWindow(window1, cell1, face1)) {
+    err << "Error: Wrong input window (" << window1 << ")" << Qt::endl;
+    err << "Abort." << Qt::endl;
+    return 1;
+  }
+  if ((window2 != "") && !readWindow(window2, cell2, face2)) {
+    err << "Error: Wrong output window (" << window2 << ")" << Qt::endl;
+    err << "Abort." << Qt::endl;
+    return 1;
+  }
+
+  QVector<Board> boards;
+  try {
+    Generator generator(size[0], size[1], size[2], cell1, face1, cell2, face2);
+    generator.setMinLength(minLength).setMaxTries(tries).setStable(stable).setUnique(unique);
+    out << "Generating " << number << " board(s) using " << threads << " thread(s)" << Qt::endl;
+    boards = generator.generate(number, threads, seed);
+  }
+  catch (Exception &) {
+    err << "Error: the windows have to be distinct, and in the border of the board" << Qt::endl;
+    err << "Abort." << Qt::endl;
+    return 2;
+  }
+
+  if (boards.isEmpty()) {
+    err << "Error: no board has been found" << Qt::endl;
+    return 3;
+  }
+  if ((unsigned int)boards.size() != number)
+    err << "Warning: only " << boards.size() << " board(s) have been found" << Qt::endl;
+
+  for(int i = 0; i != boards.size(); ++i) {
+    const QString filename = (number == 1) ? output : output + QString::number(i) + ".vg";
+    out << "Save file (" << filename << ")" << Qt::endl;
+    if (!boards[i].save(filename)) {
+      err << "Error: cannot save file (" << filename << ")" << Qt::endl;
+      return 4;
+    }
+  }
+
+  return 0;
+}